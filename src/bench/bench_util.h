@@ -0,0 +1,85 @@
+#ifndef DCR_BENCH_BENCH_UTIL_H_
+#define DCR_BENCH_BENCH_UTIL_H_
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "core/graph.h"
+#include "core/table.h"
+#include "io/memory_table.h"
+
+namespace dcr {
+
+// Synthetic table with attributes region, year and, for every FD i, lhs_i -> rhs_i.
+// Rows share lhs_i in groups of group_size, rhs_i follows lhs_i except for
+// density_percent of the rows which get a random value and so conflict with their group.
+inline std::unique_ptr<MemoryTable> MakeConflictTable(size_t rows, size_t fd_num, int density_percent,
+        size_t group_size = 4, unsigned int seed = 42) {
+    std::vector<std::string> attrs = {"region", "year"};
+    std::vector<FunctionalDependency> fds;
+    for (size_t i = 0; i < fd_num; i++) {
+        attrs.push_back("lhs_" + std::to_string(i));
+        attrs.push_back("rhs_" + std::to_string(i));
+        fds.emplace_back(std::vector<std::string>{attrs[attrs.size() - 2]}, std::vector<std::string>{attrs.back()});
+    }
+
+    std::unique_ptr<MemoryTable> table(new MemoryTable("bench", attrs));
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::vector<std::string> values(attrs.size());
+    for (size_t row = 0; row < rows; row++) {
+        values[0] = "r" + std::to_string(gen() % 16);
+        values[1] = std::to_string(2000 + gen() % 20);
+        for (size_t i = 0; i < fd_num; i++) {
+            // shift groups per FD so the FDs do not produce identical conflicts
+            size_t group = (row + i * 7) / group_size;
+            values[2 + 2 * i] = "g" + std::to_string(group);
+            if (percent(gen) < density_percent) {
+                values[3 + 2 * i] = "x" + std::to_string(gen());
+            } else {
+                values[3 + 2 * i] = "v" + std::to_string(group);
+            }
+        }
+        table->AppendRow(values);
+    }
+    table->LoadFunctionalDependencies(fds);
+    return table;
+}
+
+inline GraphOptions BenchGraphOptions() {
+    GraphOptions options;
+    options.ranking_mode_ = RankingMode::kKeyedHash;
+    options.seed_ = 42;
+    // keeps progress output out of the timed loops
+    options.verbose_ = false;
+    return options;
+}
+
+
+// Calls the private Graph phases, the solution trace is reset between runs.
+class GraphBench {
+public:
+    static void Coloring(Graph& graph) {
+        graph.Coloring(graph.Adjacency());
+    }
+
+    // the LP over the whole graph, neither kernelized nor solved exactly
+    static void LpSolver(Graph& graph) {
+        graph.LpSolver(graph.Adjacency());
+    }
+
+    static std::vector<size_t> EliminateTriangles(Graph& graph) {
+        return graph.EliminateTriangles();
+    }
+
+    static void ResetSolution(Graph& graph) {
+        for (Graph::Node& node: graph.nodes_) {
+            node.lp_ = -1.0;
+            node.color_ = Graph::kNoColor;
+        }
+    }
+};
+
+}  // dcr
+#endif  // DCR_BENCH_BENCH_UTIL_H_
@@ -0,0 +1,155 @@
+#include <memory>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "bench/bench_util.h"
+#include "core/graph.h"
+#include "core/subset_query.h"
+
+namespace dcr {
+
+// Args: rows, number of FDs, conflict density in percent
+static void GraphArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t rows: {1 << 10, 1 << 14, 1 << 17}) {
+        for (int64_t fds: {1, 4}) {
+            for (int64_t density: {1, 10, 50}) {
+                b->Args({rows, fds, density});
+            }
+        }
+    }
+}
+
+// the simplex over one row per edge dominates, keep the graphs small
+static void LpArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t rows: {1 << 7, 1 << 9, 1 << 11}) {
+        for (int64_t density: {10, 50}) {
+            b->Args({rows, 1, density});
+        }
+    }
+}
+
+static std::unique_ptr<MemoryTable> TableFor(const benchmark::State& state) {
+    return MakeConflictTable(state.range(0), state.range(1), state.range(2));
+}
+
+static void BM_GraphInitialize(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = TableFor(state);
+    for (auto _ : state) {
+        Graph graph(table.get(), BenchGraphOptions());
+        benchmark::DoNotOptimize(&graph);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GraphInitialize)->Apply(GraphArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_Coloring(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = TableFor(state);
+    Graph graph(table.get(), BenchGraphOptions());
+    for (auto _ : state) {
+        state.PauseTiming();
+        GraphBench::ResetSolution(graph);
+        state.ResumeTiming();
+        GraphBench::Coloring(graph);
+    }
+}
+BENCHMARK(BM_Coloring)->Apply(GraphArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_LpSolver(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = TableFor(state);
+    Graph graph(table.get(), BenchGraphOptions());
+    for (auto _ : state) {
+        GraphBench::LpSolver(graph);
+    }
+}
+BENCHMARK(BM_LpSolver)->Apply(LpArgs)->Unit(benchmark::kMillisecond);
+
+// EliminateTriangles and VertexCoverTelp consume the graph, it is rebuilt untimed
+static void BM_EliminateTriangles(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = TableFor(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Graph> graph(new Graph(table.get(), BenchGraphOptions()));
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(GraphBench::EliminateTriangles(*graph));
+        state.PauseTiming();
+        graph.reset();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_EliminateTriangles)->Apply(LpArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_VertexCoverBllp(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = TableFor(state);
+    Graph graph(table.get(), BenchGraphOptions());
+    std::vector<size_t> vc;
+    for (auto _ : state) {
+        vc = graph.VertexCoverBllp();
+        benchmark::DoNotOptimize(vc);
+    }
+    state.counters["cover"] = vc.size();
+}
+BENCHMARK(BM_VertexCoverBllp)->Apply(LpArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_VertexCoverTelp(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = TableFor(state);
+    std::vector<size_t> vc;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Graph> graph(new Graph(table.get(), BenchGraphOptions()));
+        state.ResumeTiming();
+        vc = graph->VertexCoverTelp();
+        benchmark::DoNotOptimize(vc);
+        state.PauseTiming();
+        graph.reset();
+        state.ResumeTiming();
+    }
+    state.counters["cover"] = vc.size();
+}
+BENCHMARK(BM_VertexCoverTelp)->Apply(LpArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_VertexCoverPrimalDual(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = TableFor(state);
+    Graph graph(table.get(), BenchGraphOptions());
+    std::vector<size_t> vc;
+    for (auto _ : state) {
+        vc = graph.VertexCoverPrimalDual();
+        benchmark::DoNotOptimize(vc);
+    }
+    state.counters["cover"] = vc.size();
+    state.SetItemsProcessed(state.iterations() * graph.GetEdgeNum());
+}
+BENCHMARK(BM_VertexCoverPrimalDual)->Apply(GraphArgs)->Unit(benchmark::kMillisecond);
+
+// Args: as GraphArgs, plus threads
+static void BM_VertexCoverPrimalDualParallel(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = TableFor(state);
+    Graph graph(table.get(), BenchGraphOptions());
+    std::vector<size_t> vc;
+    for (auto _ : state) {
+        vc = graph.VertexCoverPrimalDualParallel(state.range(3));
+        benchmark::DoNotOptimize(vc);
+    }
+    state.counters["cover"] = vc.size();
+    state.SetItemsProcessed(state.iterations() * graph.GetEdgeNum());
+}
+BENCHMARK(BM_VertexCoverPrimalDualParallel)
+    ->ArgsProduct({{1 << 17}, {4}, {10, 50}, {1, 4}})
+    ->Unit(benchmark::kMillisecond);
+
+// Args: rows, number of FDs, conflict density in percent, epsilon in thousandths
+static void BM_InconsistencyDegree(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = TableFor(state);
+    Graph graph(table.get(), BenchGraphOptions());
+    SubsetQuery query("year >= 2010");
+    double epsilon = state.range(3) / 1000.0;
+    double estimate = 0.0;
+    for (auto _ : state) {
+        estimate = graph.InconsistencyDegree(epsilon, query);
+        benchmark::DoNotOptimize(estimate);
+    }
+    state.counters["estimate"] = estimate;
+}
+BENCHMARK(BM_InconsistencyDegree)
+    ->ArgsProduct({{1 << 14, 1 << 17}, {1, 4}, {1, 10, 50}, {200, 100, 50}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // dcr
@@ -0,0 +1,70 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "bench/bench_util.h"
+#include "core/oracle.h"
+#include "core/query_cache.h"
+#include "core/subset_query.h"
+
+namespace dcr {
+
+static const char* kQueries[] = {
+    "year >= 2010",
+    "region = r3 and year < 2005",
+    "(region = r1 or region = r2) and year != 2015",
+};
+
+// Args: rows, query index
+static void BM_OracleConstruction(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = MakeConflictTable(state.range(0), 1, 10);
+    SubsetQuery query(kQueries[state.range(1)]);
+    for (auto _ : state) {
+        Oracle oracle(*table, query);
+        benchmark::DoNotOptimize(oracle.NumberofNodesInSubgraph());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OracleConstruction)->ArgsProduct({{1 << 12, 1 << 16, 1 << 20}, {0, 1, 2}})->Unit(benchmark::kMillisecond);
+
+// same queries with bitmap indexes on the categorical columns
+static void BM_OracleBitmapIndex(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = MakeConflictTable(state.range(0), 1, 10);
+    table->CreateBitmapIndex("region");
+    table->CreateBitmapIndex("year");
+    SubsetQuery query(kQueries[state.range(1)]);
+    for (auto _ : state) {
+        Oracle oracle(*table, query);
+        benchmark::DoNotOptimize(oracle.NumberofNodesInSubgraph());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OracleBitmapIndex)->ArgsProduct({{1 << 16, 1 << 20}, {0, 1, 2}})->Unit(benchmark::kMillisecond);
+
+// re-issued query text: parse and scan are served from the cache
+static void BM_OracleCached(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = MakeConflictTable(state.range(0), 1, 10);
+    QueryCache cache;
+    for (auto _ : state) {
+        std::shared_ptr<const SubsetQuery> query = cache.GetQuery(kQueries[1]);
+        benchmark::DoNotOptimize(cache.GetOracle(*table, *query)->NumberofNodesInSubgraph());
+    }
+}
+BENCHMARK(BM_OracleCached)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_SubsetQuerySatisfy(benchmark::State& state) {
+    std::unique_ptr<MemoryTable> table = MakeConflictTable(1 << 12, 1, 10);
+    std::vector<Record> records;
+    for (size_t i = 0; i < table->GetTotalRowNum(); i++) {
+        records.push_back(table->GetRecord(i));
+    }
+    SubsetQuery query(kQueries[state.range(0)]);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(query.Satisfy(records[i]));
+        i = (i + 1) % records.size();
+    }
+}
+BENCHMARK(BM_SubsetQuerySatisfy)->DenseRange(0, 2);
+
+}  // dcr
@@ -0,0 +1,119 @@
+#ifndef DCR_CORE_BITMAP_H_
+#define DCR_CORE_BITMAP_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace dcr {
+
+// Plain dense bitmap over row indexes, grows on Set.
+class Bitmap {
+public:
+    Bitmap() = default;
+
+    explicit Bitmap(size_t size): words_((size + 63) / 64, 0), size_(size) {}
+
+    inline void Set(size_t idx) {
+        if (idx >= size_) {
+            size_ = idx + 1;
+            words_.resize((size_ + 63) / 64, 0);
+        }
+        words_[idx >> 6] |= (uint64_t)1 << (idx & 63);
+    }
+
+    inline bool Test(size_t idx) const {
+        if (idx >= size_) {
+            return false;
+        }
+        return (words_[idx >> 6] >> (idx & 63)) & 1;
+    }
+
+    size_t Count() const {
+        size_t count = 0;
+        for (uint64_t w: words_) {
+            count += __builtin_popcountll(w);
+        }
+        return count;
+    }
+
+    inline size_t Size() const {
+        return size_;
+    }
+
+    void And(const Bitmap& other) {
+        for (size_t i = 0; i < words_.size(); i++) {
+            words_[i] &= i < other.words_.size() ? other.words_[i] : 0;
+        }
+    }
+
+    void Or(const Bitmap& other) {
+        if (other.size_ > size_) {
+            size_ = other.size_;
+            words_.resize(other.words_.size(), 0);
+        }
+        for (size_t i = 0; i < other.words_.size(); i++) {
+            words_[i] |= other.words_[i];
+        }
+    }
+
+    // complement within [0, size)
+    void Flip(size_t size) {
+        size_ = size;
+        words_.resize((size + 63) / 64, 0);
+        for (uint64_t& w: words_) {
+            w = ~w;
+        }
+        if (size & 63) {
+            words_.back() &= ((uint64_t)1 << (size & 63)) - 1;
+        }
+    }
+
+    // appends every set index in ascending order
+    void ToVector(std::vector<size_t>* out) const {
+        for (size_t i = 0; i < words_.size(); i++) {
+            uint64_t w = words_[i];
+            while (w != 0) {
+                out->push_back(i * 64 + __builtin_ctzll(w));
+                w &= w - 1;
+            }
+        }
+    }
+
+    size_t Hash() const {
+        size_t h = 1469598103934665603ULL;
+        for (size_t i = 0; i < LastNonZero(); i++) {
+            h = (h ^ words_[i]) * 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // equality of the set index sets, independent of the allocated size
+    bool operator==(const Bitmap& other) const {
+        size_t n = LastNonZero();
+        if (n != other.LastNonZero()) {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (words_[i] != other.words_[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    size_t LastNonZero() const {
+        size_t n = words_.size();
+        while (n > 0 && words_[n - 1] == 0) {
+            n--;
+        }
+        return n;
+    }
+
+    std::vector<uint64_t> words_;
+    size_t size_ = 0;
+};
+
+}  // dcr
+#endif  // DCR_CORE_BITMAP_H_
@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <functional>
+#include "core/conflict_group.h"
+
+namespace dcr {
+using std::pair;
+using std::vector;
+
+typedef std::greater<pair<EdgeRank, size_t>> MinHeapOrder;
+
+GroupNeighbourOrder::GroupNeighbourOrder(size_t node_id,
+        const vector<pair<const ConflictGroup*, size_t>>& memberships, const EdgeRanker& ranker) {
+    for (const pair<const ConflictGroup*, size_t>& membership: memberships) {
+        const ConflictGroup* group = membership.first;
+        uint32_t rhs_class = group->GetRhsClass(membership.second);
+        for (size_t i = 0; i < group->Size(); i++) {
+            if (group->GetRhsClass(i) != rhs_class) {
+                size_t v = group->GetMember(i);
+                heap_.emplace_back(ranker.Rank(node_id, v), v);
+            }
+        }
+    }
+    std::make_heap(heap_.begin(), heap_.end(), MinHeapOrder());
+}
+
+bool GroupNeighbourOrder::Has(size_t pos) {
+    while (sorted_.size() <= pos && !heap_.empty()) {
+        if (sorted_.empty() || heap_.front() != sorted_.back()) {
+            sorted_.push_back(heap_.front());
+        }
+        Pop();
+    }
+    return pos < sorted_.size();
+}
+
+void GroupNeighbourOrder::Pop() {
+    std::pop_heap(heap_.begin(), heap_.end(), MinHeapOrder());
+    heap_.pop_back();
+}
+
+}  // dcr
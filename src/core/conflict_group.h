@@ -0,0 +1,95 @@
+#ifndef DCR_CORE_CONFLICT_GROUP_H_
+#define DCR_CORE_CONFLICT_GROUP_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "core/edge_ranker.h"
+#include "core/types.h"
+
+namespace dcr {
+
+// Rows sharing one LHS value of a functional dependency. Two members conflict iff their
+// RHS class labels differ, so the clique is kept implicitly instead of as O(k^2) edges.
+class ConflictGroup {
+public:
+    ConflictGroup() = default;
+
+    void AddMember(NodeId node_id, uint32_t rhs_class) {
+        members_.push_back(node_id);
+        rhs_classes_.push_back(rhs_class);
+    }
+
+    inline size_t Size() const {
+        return members_.size();
+    }
+
+    inline size_t GetMember(size_t pos) const {
+        return members_[pos];
+    }
+
+    inline uint32_t GetRhsClass(size_t pos) const {
+        return rhs_classes_[pos];
+    }
+
+private:
+    std::vector<NodeId> members_;
+    std::vector<uint32_t> rhs_classes_;
+};
+
+
+// Neighbours of one node inside its conflict groups in ascending (rank, neighbour) order.
+// Built as a heap in O(k) and sorted only as far as it is read, so a caller that stops
+// after the few lowest ranked neighbours never sorts the group. Shared by every
+// iterator over the node's neighbours.
+class GroupNeighbourOrder {
+public:
+    // memberships are (group, position of node_id in that group)
+    GroupNeighbourOrder(size_t node_id, const std::vector<std::pair<const ConflictGroup*, size_t>>& memberships,
+            const EdgeRanker& ranker);
+
+    // whether the node has more than pos group neighbours, sorting up to pos if so
+    bool Has(size_t pos);
+
+    // (rank, neighbour) of the pos-th neighbour, after Has(pos)
+    inline const std::pair<EdgeRank, size_t>& Get(size_t pos) const {
+        return sorted_[pos];
+    }
+
+private:
+    void Pop();
+
+    std::vector<std::pair<EdgeRank, size_t>> heap_;
+    // duplicates from another group are dropped here
+    std::vector<std::pair<EdgeRank, size_t>> sorted_;
+};
+
+
+// Cursor over a GroupNeighbourOrder.
+class GroupNeighbourIterator {
+public:
+    GroupNeighbourIterator() = default;
+
+    explicit GroupNeighbourIterator(std::shared_ptr<GroupNeighbourOrder> order): order_(std::move(order)) {}
+
+    inline bool HasNext() const {
+        return order_ != nullptr && order_->Has(pos_);
+    }
+
+    // (rank, neighbour) of the current neighbour
+    inline const std::pair<EdgeRank, size_t>& Peek() const {
+        return order_->Get(pos_);
+    }
+
+    inline void Next() {
+        pos_++;
+    }
+
+private:
+    std::shared_ptr<GroupNeighbourOrder> order_;
+    size_t pos_ = 0;
+};
+
+}  // dcr
+#endif  // DCR_CORE_CONFLICT_GROUP_H_
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <limits>
+#include "core/cover_kernel.h"
+#include "core/exact_cover.h"
+
+namespace dcr {
+using std::vector;
+
+static const size_t kNone = std::numeric_limits<size_t>::max();
+
+static inline bool Contains(const vector<size_t>& list, size_t v) {
+    return std::binary_search(list.begin(), list.end(), v);
+}
+
+static inline void Insert(vector<size_t>* list, size_t v) {
+    auto iter = std::lower_bound(list->begin(), list->end(), v);
+    if (iter == list->end() || *iter != v) {
+        list->insert(iter, v);
+    }
+}
+
+static inline void Erase(vector<size_t>* list, size_t v) {
+    auto iter = std::lower_bound(list->begin(), list->end(), v);
+    if (iter != list->end() && *iter == v) {
+        list->erase(iter);
+    }
+}
+
+VertexCoverKernel::VertexCoverKernel(vector<vector<size_t>>* adj, const vector<double>* weights): adj_(*adj),
+        weights_(weights), alive_(adj->size(), 0) {
+    for (size_t v = 0; v < adj_.size(); v++) {
+        alive_[v] = !adj_[v].empty();
+    }
+}
+
+void VertexCoverKernel::Reduce() {
+    for (size_t v = 0; v < adj_.size(); v++) {
+        if (alive_[v]) {
+            worklist_.push_back(v);
+        }
+    }
+    // the cheap rules run to a fixpoint before each of the expensive ones
+    while (true) {
+        ReduceLowDegree();
+        if (ReduceDominated()) {
+            continue;
+        }
+        if (ReduceCrown()) {
+            continue;
+        }
+        break;
+    }
+}
+
+vector<size_t> VertexCoverKernel::Lift(const vector<size_t>& cover) const {
+    vector<char> in_cover(adj_.size(), 0);
+    for (size_t v: cover) {
+        in_cover[v] = 1;
+    }
+    for (size_t v: taken_) {
+        in_cover[v] = 1;
+    }
+    // later folds may have merged into the representative of an earlier one
+    for (auto iter = folds_.rbegin(); iter != folds_.rend(); iter++) {
+        const std::array<size_t, 3>& fold = *iter;
+        if (in_cover[fold[1]]) {
+            in_cover[fold[2]] = 1;
+        } else {
+            in_cover[fold[0]] = 1;
+        }
+    }
+    vector<size_t> lifted;
+    for (size_t v = 0; v < adj_.size(); v++) {
+        if (in_cover[v]) {
+            lifted.push_back(v);
+        }
+    }
+    return lifted;
+}
+
+void VertexCoverKernel::ReduceLowDegree() {
+    while (!worklist_.empty()) {
+        size_t v = worklist_.back();
+        worklist_.pop_back();
+        if (!alive_[v]) {
+            continue;
+        }
+        const vector<size_t>& neighbours = adj_[v];
+        if (neighbours.empty()) {
+            Drop(v);
+        } else if (neighbours.size() == 1) {
+            if (Weight(v) >= Weight(neighbours[0])) {
+                Take(neighbours[0]);
+            }
+        } else if (neighbours.size() == 2) {
+            size_t u = neighbours[0], w = neighbours[1];
+            if (Contains(adj_[u], w)) {
+                if (Weight(v) >= std::max(Weight(u), Weight(w))) {
+                    Take(u);
+                    Take(w);
+                }
+            } else if (weights_ == nullptr) {
+                Fold(v, u, w);
+            }
+        }
+    }
+}
+
+bool VertexCoverKernel::ReduceDominated() {
+    bool changed = false;
+    for (size_t v = 0; v < adj_.size(); v++) {
+        if (!alive_[v] || adj_[v].size() > kMaxDominanceDegree) {
+            continue;
+        }
+        bool dominates = false;
+        for (size_t u: adj_[v]) {
+            if (adj_[u].size() > adj_[v].size() || Weight(u) < Weight(v)) {
+                continue;
+            }
+            dominates = true;
+            for (size_t x: adj_[u]) {
+                if (x != v && !Contains(adj_[v], x)) {
+                    dominates = false;
+                    break;
+                }
+            }
+            if (dominates) {
+                break;
+            }
+        }
+        if (dominates) {
+            Take(v);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool VertexCoverKernel::ReduceCrown() {
+    vector<size_t> index(adj_.size(), kNone);
+    vector<size_t> nodes;
+    for (size_t v = 0; v < adj_.size(); v++) {
+        if (alive_[v]) {
+            index[v] = nodes.size();
+            nodes.push_back(v);
+        }
+    }
+    if (nodes.empty()) {
+        return false;
+    }
+
+    // node i has copies i and k + i of its weight, edge {v, w} becomes {v, k + w} and
+    // {w, k + v}
+    size_t k = nodes.size();
+    vector<vector<size_t>> double_adj(2 * k);
+    for (size_t i = 0; i < k; i++) {
+        for (size_t w: adj_[nodes[i]]) {
+            double_adj[i].push_back(k + index[w]);
+            double_adj[k + index[w]].push_back(i);
+        }
+    }
+    vector<double> double_weights;
+    if (weights_ != nullptr) {
+        for (size_t copy = 0; copy < 2; copy++) {
+            for (size_t v: nodes) {
+                double_weights.push_back(Weight(v));
+            }
+        }
+    }
+    vector<size_t> cover;
+    ExactVertexCover(double_adj, weights_ == nullptr ? nullptr : &double_weights).SolveBipartite(&cover);
+    vector<int> copies(k, 0);
+    for (size_t c: cover) {
+        copies[c < k ? c : c - k]++;
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < k; i++) {
+        if (copies[i] == 2) {
+            Take(nodes[i]);
+            changed = true;
+        }
+    }
+    // every neighbour of a 0-node is a 1-node, so these are isolated by now
+    for (size_t i = 0; i < k; i++) {
+        if (copies[i] == 0 && alive_[nodes[i]]) {
+            Drop(nodes[i]);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void VertexCoverKernel::Take(size_t v) {
+    Detach(v);
+    taken_.push_back(v);
+}
+
+void VertexCoverKernel::Drop(size_t v) {
+    Detach(v);
+}
+
+void VertexCoverKernel::Fold(size_t v, size_t u, size_t w) {
+    Detach(v);
+    for (size_t x: adj_[w]) {
+        Erase(&adj_[x], w);
+        Insert(&adj_[x], u);
+        Insert(&adj_[u], x);
+        worklist_.push_back(x);
+    }
+    adj_[w].clear();
+    alive_[w] = 0;
+    removed_num_++;
+    worklist_.push_back(u);
+    folds_.push_back({v, u, w});
+}
+
+void VertexCoverKernel::Detach(size_t v) {
+    for (size_t w: adj_[v]) {
+        Erase(&adj_[w], v);
+        worklist_.push_back(w);
+    }
+    adj_[v].clear();
+    alive_[v] = 0;
+    removed_num_++;
+}
+
+}  // dcr
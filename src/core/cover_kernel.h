@@ -0,0 +1,71 @@
+#ifndef DCR_CORE_COVER_KERNEL_H_
+#define DCR_CORE_COVER_KERNEL_H_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace dcr {
+
+// Shrinks a vertex cover instance with the classic reduction rules and lifts a cover of
+// the reduced graph back to one of the input, both of the same optimality. The graph is
+// given as sorted adjacency lists over node ids and reduced in place, removed nodes are
+// left with empty lists. With node weights the rules only fire where they keep a minimum
+// weight cover, and degree-2 folding is off.
+class VertexCoverKernel {
+public:
+    // nodes above this degree are not tested for dominance, which is quadratic in it
+    static constexpr size_t kMaxDominanceDegree = 256;
+
+    // weights, if given, are indexed by node id and must outlive the kernel
+    explicit VertexCoverKernel(std::vector<std::vector<size_t>>* adj, const std::vector<double>* weights = nullptr);
+
+    // applies the rules until none of them changes the graph
+    void Reduce();
+
+    // cover of the input graph from a cover of the reduced one
+    std::vector<size_t> Lift(const std::vector<size_t>& cover) const;
+
+    // nodes decided by the rules so far
+    inline size_t GetRemovedNum() const {
+        return removed_num_;
+    }
+
+private:
+    inline double Weight(size_t v) const {
+        return weights_ == nullptr ? 1.0 : (*weights_)[v];
+    }
+
+    // degree 0 (dropped), degree 1 (neighbour taken) and degree 2 (both neighbours of a
+    // triangle taken, otherwise the node and its neighbours folded into one) from a worklist
+    void ReduceLowDegree();
+
+    // a node whose closed neighbourhood contains the one of a no lighter neighbour is taken
+    bool ReduceDominated();
+
+    // Crown reduction in its LP form (Nemhauser-Trotter): a minimum cover of the bipartite
+    // double cover gives a half-integral optimum of the LP relaxation, its 1-nodes are
+    // taken and its 0-nodes dropped.
+    bool ReduceCrown();
+
+    void Take(size_t v);
+
+    void Drop(size_t v);
+
+    // v of degree 2 with non-adjacent neighbours u and w: u stands for all three from now on
+    void Fold(size_t v, size_t u, size_t w);
+
+    void Detach(size_t v);
+
+    std::vector<std::vector<size_t>>& adj_;
+    const std::vector<double>* weights_;
+    std::vector<char> alive_;
+    std::vector<size_t> worklist_;
+    std::vector<size_t> taken_;
+    // (v, u, w) of every fold in order
+    std::vector<std::array<size_t, 3>> folds_;
+    size_t removed_num_ = 0;
+};
+
+}  // dcr
+#endif  // DCR_CORE_COVER_KERNEL_H_
@@ -0,0 +1,73 @@
+#ifndef DCR_CORE_EDGE_RANKER_H_
+#define DCR_CORE_EDGE_RANKER_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include "core/types.h"
+
+namespace dcr {
+
+enum class RankingMode {
+    kRandomSequence,  // ranks drawn from RandomSequenceOfUnique and stored with the edge
+    kKeyedHash        // ranks recomputed from a keyed hash of the endpoints
+};
+
+// Pseudo-random sequence of distinct 32-bit values (Preshing): two rounds of the
+// quadratic residue permutation modulo the largest 32-bit prime applied to a counter.
+class RandomSequenceOfUnique {
+public:
+    RandomSequenceOfUnique(unsigned int seed_base, unsigned int seed_offset):
+            index_(Permute(Permute(seed_base) + 0x682f0161)),
+            intermediate_offset_(Permute(Permute(seed_offset) + 0x46790905)) {}
+
+    inline unsigned int Next() {
+        return Permute((Permute(index_++) + intermediate_offset_) ^ 0x5bf03635);
+    }
+
+private:
+    static inline unsigned int Permute(unsigned int x) {
+        static const unsigned int kPrime = 4294967291u;
+        if (x >= kPrime) {
+            // the 5 values above the prime map to themselves
+            return x;
+        }
+        unsigned int residue = (unsigned int)(((uint64_t)x * x) % kPrime);
+        return x <= kPrime / 2 ? residue : kPrime - residue;
+    }
+
+    unsigned int index_;
+    unsigned int intermediate_offset_;
+};
+
+// Random edge permutation without storage: the rank of {u, v} is a seeded 64-bit mix
+// of the unordered endpoint pair truncated to EdgeRank, so every thread or process using
+// the same seed sees the same permutation. Equal ranks are ordered by the pair itself.
+class EdgeRanker {
+public:
+    explicit EdgeRanker(uint64_t seed = 0): seed_(seed), key_(Mix(seed + 0x9e3779b97f4a7c15ULL)) {}
+
+    inline EdgeRank Rank(size_t u, size_t v) const {
+        uint64_t a = std::min(u, v);
+        uint64_t b = std::max(u, v);
+        return (EdgeRank)Mix(Mix(a ^ key_) + b);
+    }
+
+    inline uint64_t GetSeed() const {
+        return seed_;
+    }
+
+private:
+    // splitmix64 finalizer
+    static inline uint64_t Mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t seed_;
+    uint64_t key_;
+};
+
+}  // dcr
+#endif  // DCR_CORE_EDGE_RANKER_H_
@@ -0,0 +1,484 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+#include "core/exact_cover.h"
+
+namespace dcr {
+using std::vector;
+
+static const size_t kNone = std::numeric_limits<size_t>::max();
+
+ExactVertexCover::ExactVertexCover(const vector<vector<size_t>>& adj, const vector<double>* weights): adj_(adj),
+        weights_(weights), edge_num_(0) {
+    for (const vector<size_t>& neighbours: adj_) {
+        edge_num_ += neighbours.size();
+    }
+    edge_num_ /= 2;
+}
+
+bool ExactVertexCover::SolveClosedForm(vector<size_t>* cover) const {
+    size_t n = adj_.size();
+    cover->clear();
+    if (edge_num_ == 0) {
+        return true;
+    }
+    size_t max_degree = 0, center = 0, leaf = kNone, heaviest = 0;
+    double total = 0.0;
+    for (size_t v = 0; v < n; v++) {
+        if (adj_[v].size() > max_degree) {
+            max_degree = adj_[v].size();
+            center = v;
+        }
+        if (adj_[v].size() == 1) {
+            leaf = v;
+        }
+        if (Weight(v) > Weight(heaviest)) {
+            heaviest = v;
+        }
+        total += Weight(v);
+    }
+    // clique: all nodes but the heaviest
+    if (edge_num_ == n * (n - 1) / 2) {
+        for (size_t v = 0; v < n; v++) {
+            if (v != heaviest) {
+                cover->push_back(v);
+            }
+        }
+        return true;
+    }
+    // star: the center or all leaves
+    if (edge_num_ == n - 1 && max_degree == n - 1) {
+        if (Weight(center) <= total - Weight(center)) {
+            cover->push_back(center);
+        } else {
+            for (size_t v = 0; v < n; v++) {
+                if (v != center) {
+                    cover->push_back(v);
+                }
+            }
+        }
+        return true;
+    }
+    if (max_degree > 2 || (edge_num_ != n - 1 && edge_num_ != n)) {
+        return false;
+    }
+    if (edge_num_ == n - 1) {
+        PathCover(Walk(leaf), -1, false, cover);
+        return true;
+    }
+    // a cycle either covers its first node or both of that node's neighbours
+    vector<size_t> order = Walk(0);
+    vector<size_t> without_first;
+    if (PathCover(order, 0, true, &without_first) < PathCover(order, 1, false, cover)) {
+        cover->swap(without_first);
+    }
+    return true;
+}
+
+vector<size_t> ExactVertexCover::Walk(size_t start) const {
+    vector<size_t> order(1, start);
+    size_t prev = start;
+    size_t cur = start;
+    while (order.size() < adj_.size()) {
+        size_t next = (cur == start || adj_[cur][0] != prev) ? adj_[cur][0] : adj_[cur][1];
+        prev = cur;
+        cur = next;
+        order.push_back(cur);
+    }
+    return order;
+}
+
+double ExactVertexCover::PathCover(const vector<size_t>& order, int first, bool last_in, vector<size_t>* cover) const {
+    // cost[i][s]: lightest cover of order[0..i] with order[i] out (s = 0) or in (s = 1)
+    const double kInf = std::numeric_limits<double>::infinity();
+    vector<std::array<double, 2>> cost(order.size());
+    cost[0][0] = first == 1 ? kInf : 0.0;
+    cost[0][1] = first == 0 ? kInf : Weight(order[0]);
+    for (size_t i = 1; i < order.size(); i++) {
+        cost[i][0] = cost[i - 1][1];
+        cost[i][1] = std::min(cost[i - 1][0], cost[i - 1][1]) + Weight(order[i]);
+    }
+    size_t last = order.size() - 1;
+    int state = last_in || cost[last][1] <= cost[last][0] ? 1 : 0;
+    double weight = cost[last][state];
+    cover->clear();
+    for (size_t i = last + 1; i-- > 0;) {
+        if (state == 1) {
+            cover->push_back(order[i]);
+            state = i > 0 && cost[i - 1][0] < cost[i - 1][1] ? 0 : 1;
+        } else {
+            state = 1;
+        }
+    }
+    return weight;
+}
+
+vector<int> ExactVertexCover::TwoColoring() const {
+    vector<int> side(adj_.size(), -1);
+    vector<size_t> queue;
+    for (size_t s = 0; s < adj_.size(); s++) {
+        if (side[s] != -1) {
+            continue;
+        }
+        side[s] = 0;
+        queue.assign(1, s);
+        for (size_t head = 0; head < queue.size(); head++) {
+            size_t u = queue[head];
+            for (size_t w: adj_[u]) {
+                if (side[w] == -1) {
+                    side[w] = 1 - side[u];
+                    queue.push_back(w);
+                } else if (side[w] == side[u]) {
+                    return vector<int>();
+                }
+            }
+        }
+    }
+    return side;
+}
+
+bool ExactVertexCover::SolveBipartite(vector<size_t>* cover) const {
+    vector<int> side = TwoColoring();
+    if (side.empty()) {
+        return false;
+    }
+    if (weights_ == nullptr) {
+        MaximumMatchingCover(side, cover);
+    } else {
+        MinimumCutCover(side, cover);
+    }
+    return true;
+}
+
+void ExactVertexCover::MaximumMatchingCover(const vector<int>& side, vector<size_t>* cover) const {
+    size_t n = adj_.size();
+    vector<size_t> left;
+    for (size_t v = 0; v < n; v++) {
+        if (side[v] == 0) {
+            left.push_back(v);
+        }
+    }
+
+    // Hopcroft-Karp: BFS layers from the free left nodes, then augmenting paths along the
+    // layers with an explicit stack, so deep components don't exhaust the call stack
+    vector<size_t> match(n, kNone);
+    vector<size_t> dist(n), next_edge(n);
+    vector<size_t> queue, stack;
+    while (true) {
+        queue.clear();
+        for (size_t u: left) {
+            dist[u] = match[u] == kNone ? 0 : kNone;
+            if (match[u] == kNone) {
+                queue.push_back(u);
+            }
+        }
+        bool found = false;
+        for (size_t head = 0; head < queue.size(); head++) {
+            size_t u = queue[head];
+            for (size_t w: adj_[u]) {
+                size_t x = match[w];
+                if (x == kNone) {
+                    found = true;
+                } else if (dist[x] == kNone) {
+                    dist[x] = dist[u] + 1;
+                    queue.push_back(x);
+                }
+            }
+        }
+        if (!found) {
+            break;
+        }
+
+        for (size_t u: left) {
+            next_edge[u] = 0;
+        }
+        for (size_t root: left) {
+            if (match[root] != kNone) {
+                continue;
+            }
+            stack.assign(1, root);
+            while (!stack.empty()) {
+                size_t u = stack.back();
+                if (next_edge[u] == adj_[u].size()) {
+                    dist[u] = kNone;
+                    stack.pop_back();
+                    continue;
+                }
+                size_t w = adj_[u][next_edge[u]];
+                size_t x = match[w];
+                if (x == kNone) {
+                    // flip the path: every left node on the stack takes its current edge
+                    for (size_t a: stack) {
+                        size_t b = adj_[a][next_edge[a]];
+                        match[a] = b;
+                        match[b] = a;
+                    }
+                    break;
+                } else if (dist[x] != kNone && dist[x] == dist[u] + 1) {
+                    stack.push_back(x);
+                } else {
+                    next_edge[u]++;
+                }
+            }
+        }
+    }
+
+    // König: Z holds the nodes reachable from free left nodes along alternating paths,
+    // the cover is (left \ Z) + (right & Z)
+    vector<char> reached(n, 0);
+    queue.clear();
+    for (size_t u: left) {
+        if (match[u] == kNone) {
+            reached[u] = 1;
+            queue.push_back(u);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); head++) {
+        size_t u = queue[head];
+        for (size_t w: adj_[u]) {
+            if (reached[w] || match[u] == w) {
+                continue;
+            }
+            reached[w] = 1;
+            if (match[w] != kNone && !reached[match[w]]) {
+                reached[match[w]] = 1;
+                queue.push_back(match[w]);
+            }
+        }
+    }
+    cover->clear();
+    for (size_t v = 0; v < n; v++) {
+        if ((side[v] == 0) != (reached[v] != 0)) {
+            cover->push_back(v);
+        }
+    }
+}
+
+void ExactVertexCover::MinimumCutCover(const vector<int>& side, vector<size_t>* cover) const {
+    // source -> left node (its weight) -> right node (unbounded) -> sink (its weight), the
+    // nodes cut off by a minimum cut form a minimum weight cover; Dinic with explicit
+    // stacks, edge e ^ 1 is the reverse of e
+    const double kInf = std::numeric_limits<double>::infinity();
+    size_t n = adj_.size();
+    size_t source = n, sink = n + 1;
+    vector<size_t> to;
+    vector<double> capacity;
+    vector<vector<size_t>> out(n + 2);
+    auto add_edge = [&](size_t u, size_t v, double cap) {
+        out[u].push_back(to.size());
+        to.push_back(v);
+        capacity.push_back(cap);
+        out[v].push_back(to.size());
+        to.push_back(u);
+        capacity.push_back(0.0);
+    };
+    for (size_t v = 0; v < n; v++) {
+        if (side[v] == 0) {
+            add_edge(source, v, Weight(v));
+            for (size_t w: adj_[v]) {
+                add_edge(v, w, kInf);
+            }
+        } else {
+            add_edge(v, sink, Weight(v));
+        }
+    }
+
+    vector<size_t> level(n + 2), next_edge(n + 2), queue, path;
+    auto bfs = [&]() {
+        std::fill(level.begin(), level.end(), kNone);
+        level[source] = 0;
+        queue.assign(1, source);
+        for (size_t head = 0; head < queue.size(); head++) {
+            size_t u = queue[head];
+            for (size_t e: out[u]) {
+                if (capacity[e] > 0.0 && level[to[e]] == kNone) {
+                    level[to[e]] = level[u] + 1;
+                    queue.push_back(to[e]);
+                }
+            }
+        }
+        return level[sink] != kNone;
+    };
+    while (bfs()) {
+        std::fill(next_edge.begin(), next_edge.end(), 0);
+        while (true) {
+            path.clear();
+            size_t u = source;
+            while (u != sink) {
+                while (next_edge[u] < out[u].size()) {
+                    size_t e = out[u][next_edge[u]];
+                    if (capacity[e] > 0.0 && level[to[e]] == level[u] + 1) {
+                        break;
+                    }
+                    next_edge[u]++;
+                }
+                if (next_edge[u] < out[u].size()) {
+                    path.push_back(out[u][next_edge[u]]);
+                    u = to[path.back()];
+                    continue;
+                }
+                // dead end, retreat along the path
+                level[u] = kNone;
+                if (path.empty()) {
+                    break;
+                }
+                u = to[path.back() ^ 1];
+                path.pop_back();
+                next_edge[u]++;
+            }
+            if (u != sink) {
+                break;
+            }
+            double flow = kInf;
+            for (size_t e: path) {
+                flow = std::min(flow, capacity[e]);
+            }
+            for (size_t e: path) {
+                capacity[e] -= flow;
+                capacity[e ^ 1] += flow;
+            }
+        }
+    }
+
+    // the source side of the minimum cut: left nodes off it and right nodes on it
+    bfs();
+    cover->clear();
+    for (size_t v = 0; v < n; v++) {
+        if ((side[v] == 0) != (level[v] != kNone)) {
+            cover->push_back(v);
+        }
+    }
+}
+
+size_t ExactVertexCover::LiveDegree(size_t v, const vector<char>& alive) const {
+    size_t degree = 0;
+    for (size_t w: adj_[v]) {
+        degree += alive[w];
+    }
+    return degree;
+}
+
+double ExactVertexCover::MatchingBound(const vector<char>& alive) const {
+    vector<char> matched(adj_.size(), 0);
+    double bound = 0.0;
+    for (size_t v = 0; v < adj_.size(); v++) {
+        if (!alive[v] || matched[v]) {
+            continue;
+        }
+        for (size_t w: adj_[v]) {
+            if (alive[w] && !matched[w]) {
+                matched[v] = matched[w] = 1;
+                bound += std::min(Weight(v), Weight(w));
+                break;
+            }
+        }
+    }
+    return bound;
+}
+
+vector<size_t> ExactVertexCover::SolveBranchAndReduce() const {
+    vector<char> alive(adj_.size(), 1);
+    vector<size_t> cover;
+    vector<size_t> best(adj_.size());
+    double best_weight = 0.0;
+    for (size_t v = 0; v < adj_.size(); v++) {
+        best[v] = v;
+        best_weight += Weight(v);
+    }
+    Branch(&alive, &cover, 0.0, &best, &best_weight);
+    return best;
+}
+
+void ExactVertexCover::Branch(vector<char>* alive, vector<size_t>* cover, double weight, vector<size_t>* best,
+        double* best_weight) const {
+    size_t mark = cover->size();
+    vector<size_t> removed;
+    auto remove = [&](size_t v, bool in_cover) {
+        (*alive)[v] = 0;
+        removed.push_back(v);
+        if (in_cover) {
+            cover->push_back(v);
+            weight += Weight(v);
+        }
+    };
+
+    // isolated nodes are dropped; a pendant node's neighbour and both neighbours of a
+    // degree-2 node inside a triangle are taken unless the node itself is lighter
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t v = 0; v < adj_.size(); v++) {
+            if (!(*alive)[v]) {
+                continue;
+            }
+            size_t live[2], degree = 0;
+            for (size_t w: adj_[v]) {
+                if ((*alive)[w]) {
+                    if (degree < 2) {
+                        live[degree] = w;
+                    }
+                    degree++;
+                }
+            }
+            if (degree == 0) {
+                remove(v, false);
+                changed = true;
+            } else if (degree == 1 && Weight(v) >= Weight(live[0])) {
+                remove(live[0], true);
+                changed = true;
+            } else if (degree == 2 && Weight(v) >= std::max(Weight(live[0]), Weight(live[1])) &&
+                    std::find(adj_[live[0]].begin(), adj_[live[0]].end(), live[1]) != adj_[live[0]].end()) {
+                remove(live[0], true);
+                remove(live[1], true);
+                changed = true;
+            }
+        }
+    }
+
+    size_t pick = kNone, max_degree = 0;
+    for (size_t v = 0; v < adj_.size(); v++) {
+        if ((*alive)[v]) {
+            size_t degree = LiveDegree(v, *alive);
+            if (degree > max_degree) {
+                max_degree = degree;
+                pick = v;
+            }
+        }
+    }
+    if (pick == kNone) {
+        if (weight < *best_weight) {
+            *best = *cover;
+            *best_weight = weight;
+        }
+    } else if (weight + MatchingBound(*alive) < *best_weight) {
+        // either pick is in the cover or all of its neighbours are
+        (*alive)[pick] = 0;
+        cover->push_back(pick);
+        Branch(alive, cover, weight + Weight(pick), best, best_weight);
+        cover->pop_back();
+
+        vector<size_t> neighbours;
+        double neighbours_weight = 0.0;
+        for (size_t w: adj_[pick]) {
+            if ((*alive)[w]) {
+                neighbours.push_back(w);
+                neighbours_weight += Weight(w);
+                (*alive)[w] = 0;
+                cover->push_back(w);
+            }
+        }
+        Branch(alive, cover, weight + neighbours_weight, best, best_weight);
+        for (size_t w: neighbours) {
+            (*alive)[w] = 1;
+        }
+        cover->resize(cover->size() - neighbours.size());
+        (*alive)[pick] = 1;
+    }
+
+    for (size_t v: removed) {
+        (*alive)[v] = 1;
+    }
+    cover->resize(mark);
+}
+
+}  // dcr
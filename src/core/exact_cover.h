@@ -0,0 +1,71 @@
+#ifndef DCR_CORE_EXACT_COVER_H_
+#define DCR_CORE_EXACT_COVER_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace dcr {
+
+// Minimum (weight) vertex covers of one connected component, given as adjacency lists
+// over local ids 0..n-1 without self loops or duplicate neighbours, and optionally the
+// non-negative weight of every node. Covers are returned as local ids.
+class ExactVertexCover {
+public:
+    // weights, if given, must outlive the solver; every node weighs 1 without
+    explicit ExactVertexCover(const std::vector<std::vector<size_t>>& adj,
+            const std::vector<double>* weights = nullptr);
+
+    // closed form for cliques and stars, dynamic program over paths and cycles, false for
+    // any other shape
+    bool SolveClosedForm(std::vector<size_t>* cover) const;
+
+    // König cover from a Hopcroft-Karp maximum matching, a minimum s-t cut when weighted;
+    // false if not bipartite
+    bool SolveBipartite(std::vector<size_t>* cover) const;
+
+    // branch and reduce, exponential in the component size
+    std::vector<size_t> SolveBranchAndReduce() const;
+
+    inline size_t GetNodeNum() const {
+        return adj_.size();
+    }
+
+    inline size_t GetEdgeNum() const {
+        return edge_num_;
+    }
+
+private:
+    inline double Weight(size_t v) const {
+        return weights_ == nullptr ? 1.0 : (*weights_)[v];
+    }
+
+    // walks a path or cycle from start, every node in visiting order
+    std::vector<size_t> Walk(size_t start) const;
+
+    // minimum cover of the path order, first is -1 (free), 0 (out) or 1 (in) for order[0],
+    // last_in forces the last node in; returns the cover weight
+    double PathCover(const std::vector<size_t>& order, int first, bool last_in, std::vector<size_t>* cover) const;
+
+    // 0 / 1 side of every node, empty if the component has an odd cycle
+    std::vector<int> TwoColoring() const;
+
+    void MaximumMatchingCover(const std::vector<int>& side, std::vector<size_t>* cover) const;
+
+    void MinimumCutCover(const std::vector<int>& side, std::vector<size_t>* cover) const;
+
+    size_t LiveDegree(size_t v, const std::vector<char>& alive) const;
+
+    // weight of a greedy maximal matching counting the lighter endpoint of every edge, a
+    // lower bound on any cover of the live nodes
+    double MatchingBound(const std::vector<char>& alive) const;
+
+    void Branch(std::vector<char>* alive, std::vector<size_t>* cover, double weight, std::vector<size_t>* best,
+            double* best_weight) const;
+
+    const std::vector<std::vector<size_t>>& adj_;
+    const std::vector<double>* weights_;
+    size_t edge_num_;
+};
+
+}  // dcr
+#endif  // DCR_CORE_EXACT_COVER_H_
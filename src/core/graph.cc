@@ -1,5 +1,14 @@
 #include "core/graph.h"
+#include <cmath>
+#include <cstdlib>
 #include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_set>
+#include <glpk.h>
+#include "core/cover_kernel.h"
+#include "core/exact_cover.h"
+#include "core/parallel.h"
 
 
 namespace dcr {
@@ -8,40 +17,70 @@ using std::vector;
 using std::unordered_map;
 
 vector<size_t> Graph::VertexCoverBllp() {
-    std::cout << "Start processing vertex cover bllp..." << std::endl;
+    if (verbose_) {
+        std::cout << "Start processing vertex cover bllp..." << std::endl;
+    }
+    if (implicit_ || !groups_.empty()) {
+        throw "Vertex cover requires a materialized graph!";
+    }
     vector<size_t> vc;
     if (edges_.size() == 0) {
         return vc;
     }
 
-    Coloring();
-    LpSolver();
-    size_t color = MostColor();
-    for (size_t i = 0; i < nodes_.size(); i++)
-        if (nodes_[i].lp_ == 1 || (nodes_[i].lp_ == 0.5 && nodes_[i].color_ != color))
-            vc.push_back(nodes_[i].GetId());
+    vc = CoverWithLp();
 
     // erase solution trace
     for (Node& node: nodes_) {
         node.lp_ = -1.0;
-        node.color_ = -1;
+        node.color_ = kNoColor;
     }
     return vc;
 }
 
+void Graph::InsertEdge(size_t u, size_t v) {
+    if (implicit_ || !groups_.empty()) {
+        throw "Edges can only be inserted into a materialized graph!";
+    }
+    if (u == v) {
+        throw "Can't insert a self-loop!";
+    }
+    if (u < nodes_.size() && v < nodes_.size()) {
+        // looked up from the endpoint with fewer edges
+        size_t from = nodes_[u].edges_.size() <= nodes_[v].edges_.size() ? u : v;
+        size_t to = from == u ? v : u;
+        for (const Edge& e: nodes_[from].edges_) {
+            if (e.v_ == to) {
+                return;
+            }
+        }
+    }
+    while (nodes_.size() <= std::max(u, v)) {
+        AddNode(nodes_.size());
+    }
+    Edge edge(u, v, NextEdgeId(), NextRanking(u, v));
+    Edge reverse(v, u, edge.edge_id_, edge.ranking_);
+    std::vector<Edge>& u_edges = nodes_[u].edges_;
+    u_edges.insert(std::upper_bound(u_edges.begin(), u_edges.end(), edge), edge);
+    std::vector<Edge>& v_edges = nodes_[v].edges_;
+    v_edges.insert(std::upper_bound(v_edges.begin(), v_edges.end(), reverse), reverse);
+    edges_.push_back(edge);
+}
+
 vector<size_t> Graph::VertexCoverTelp() {
-    std::cout << "Start processing vertex cover telp..." << std::endl;
+    if (verbose_) {
+        std::cout << "Start processing vertex cover telp..." << std::endl;
+    }
+    if (implicit_ || !groups_.empty()) {
+        throw "Vertex cover requires a materialized graph!";
+    }
     vector<size_t> vc = EliminateTriangles();
     if (edges_.size() == 0) {
         return vc;
     }
 
-    Coloring();
-    LpSolver();
-    size_t color = MostColor();
-    for (int i = 0; i < nodes_.size(); i++)
-        if (nodes_[i].lp_ == 1 || (nodes_[i].lp_ == 0.5 && nodes_[i].color_ != color))
-            vc.push_back(nodes_[i].GetId());
+    vector<size_t> rest = CoverWithLp();
+    vc.insert(vc.end(), rest.begin(), rest.end());
 
     std::sort(vc.begin(), vc.end());
     vc.erase(std::unique(vc.begin(), vc.end()), vc.end());
@@ -49,23 +88,210 @@ vector<size_t> Graph::VertexCoverTelp() {
     // erase solution trace
     for (Node& node: nodes_) {
         node.lp_ = -1.0;
-        node.color_ = -1;
+        node.color_ = kNoColor;
     }
     return vc;
 }
 
-void Graph::Coloring() {
+vector<size_t> Graph::CoverWithLp() {
+    LoadWeights();
+    vector<vector<size_t>> adj = Adjacency();
+    VertexCoverKernel kernel(&adj, weights_.empty() ? nullptr : &weights_);
+    if (kernelize_) {
+        ScopedPhase phase(&phase_times_, "kernel");
+        kernel.Reduce();
+    }
+    vector<size_t> vc = SolveExactComponents(&adj);
+    if (std::any_of(adj.begin(), adj.end(), [](const vector<size_t>& neighbours) { return !neighbours.empty(); })) {
+        Coloring(adj);
+        LpSolver(adj);
+        ScopedPhase phase(&phase_times_, "rounding");
+        size_t color = MostColor();
+        for (size_t i = 0; i < nodes_.size(); i++)
+            if (nodes_[i].lp_ == 1 || (nodes_[i].lp_ == 0.5 && nodes_[i].color_ != color))
+                vc.push_back(nodes_[i].GetId());
+    }
+    return kernel.Lift(vc);
+}
+
+vector<vector<size_t>> Graph::Adjacency() const {
+    vector<vector<size_t>> adj(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        for (const Edge& edge: nodes_[i].edges_) {
+            adj[i].push_back(edge.v_);
+        }
+        // several FDs may report the same conflict
+        std::sort(adj[i].begin(), adj[i].end());
+        adj[i].erase(std::unique(adj[i].begin(), adj[i].end()), adj[i].end());
+    }
+    return adj;
+}
+
+vector<size_t> Graph::VertexCoverPrimalDual() {
+    if (implicit_ || !groups_.empty()) {
+        throw "Vertex cover requires a materialized graph!";
+    }
+    LoadWeights();
+    vector<double> residual(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        residual[i] = Weight(i);
+    }
+    ScopedPhase phase(&phase_times_, "primal-dual");
+    // raising the dual of an edge until one endpoint is tight, tight nodes form the cover
+    for (const Edge& edge: edges_) {
+        double& u = residual[edge.u_];
+        double& v = residual[edge.v_];
+        if (u == 0.0 || v == 0.0) {
+            continue;
+        }
+        if (u <= v) {
+            v -= u;
+            u = 0.0;
+        } else {
+            u -= v;
+            v = 0.0;
+        }
+    }
+    vector<size_t> vc;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        if (residual[i] == 0.0 && !nodes_[i].edges_.empty()) {
+            vc.push_back(nodes_[i].GetId());
+        }
+    }
+    return vc;
+}
+
+vector<size_t> Graph::VertexCoverPrimalDualParallel(size_t threads) {
+    if (implicit_ || !groups_.empty()) {
+        throw "Vertex cover requires a materialized graph!";
+    }
+    ScopedPhase phase(&phase_times_, "primal-dual");
+    threads = std::max<size_t>(1, std::min(threads, nodes_.size()));
+    size_t chunk = (nodes_.size() + threads - 1) / threads;
+    vector<char> matched(nodes_.size(), 0);
+    // position of each node's lowest ranked edge to an unmatched node, adjacency lists are
+    // in rank order so it only moves forward
+    vector<size_t> next(nodes_.size(), 0);
+    vector<const Edge*> lowest(nodes_.size(), nullptr);
+    // nodes left per worker after the last round
+    vector<size_t> remaining(threads, 0);
+    Barrier barrier(threads);
+    // The workers live for all rounds, each owns a fixed range of nodes and only writes
+    // their entries. Its frontier holds the owned nodes that are unmatched and still have
+    // an edge to an unmatched node, later rounds touch nothing else.
+    ParallelFor(threads, [&](size_t t) {
+        vector<size_t> frontier;
+        for (size_t v = t * chunk; v < std::min(nodes_.size(), (t + 1) * chunk); v++) {
+            if (!nodes_[v].edges_.empty()) {
+                frontier.push_back(v);
+            }
+        }
+        while (true) {
+            for (size_t v: frontier) {
+                const vector<Edge>& edges = nodes_[v].edges_;
+                while (next[v] < edges.size() && matched[edges[next[v]].v_]) {
+                    next[v]++;
+                }
+                lowest[v] = next[v] == edges.size() ? nullptr : &edges[next[v]];
+            }
+            barrier.Wait();
+            // both endpoints pick the edge independently
+            size_t kept = 0;
+            for (size_t v: frontier) {
+                const Edge* edge = lowest[v];
+                if (edge == nullptr) {
+                    continue;
+                }
+                if (lowest[edge->v_] != nullptr && lowest[edge->v_]->edge_id_ == edge->edge_id_) {
+                    matched[v] = 1;
+                } else {
+                    frontier[kept++] = v;
+                }
+            }
+            frontier.resize(kept);
+            remaining[t] = kept;
+            barrier.Wait();
+            if (std::find_if(remaining.begin(), remaining.end(), [](size_t n) { return n != 0; }) == remaining.end()) {
+                break;
+            }
+        }
+    });
+    vector<size_t> vc;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        if (matched[i]) {
+            vc.push_back(nodes_[i].GetId());
+        }
+    }
+    return vc;
+}
+
+double Graph::GetCoverWeight(const vector<size_t>& vc) {
+    LoadWeights();
+    double weight = 0.0;
+    for (size_t v: vc) {
+        weight += Weight(v);
+    }
+    return weight;
+}
+
+void Graph::LoadWeights() {
+    if (IsWeighted() && weights_.empty()) {
+        weights_ = ReadWeights();
+    }
+}
+
+vector<double> Graph::ReadWeights() {
+    size_t col = 0;
+    if (!weight_fn_) {
+        const vector<string>& attrs = table_->GetTableAttrbutes();
+        col = std::find(attrs.begin(), attrs.end(), weight_attr_) - attrs.begin();
+        if (col == attrs.size()) {
+            throw "Weight attribute not in table!";
+        }
+    }
+    // indexed by row index, sqlite rowids start at 1 and may have gaps
+    vector<double> weights(std::max(nodes_.size(), table_->GetRowIndexBound()), 1.0);
+    std::unique_ptr<TableIterator> iter = table_->GetIterator();
+    RowBatch batch;
+    string val;
+    while (iter->NextBatch(&batch, RowBatch::kDefaultRows) != 0) {
+        for (size_t i = 0; i < batch.Size(); i++) {
+            RecordView r = batch.GetRow(i);
+            if (r.GetRowIndex() >= weights.size()) {
+                continue;
+            }
+            double weight;
+            if (weight_fn_) {
+                weight = weight_fn_(r);
+            } else {
+                val.assign(r.GetField(col).data(), r.GetField(col).size());
+                char* end = nullptr;
+                weight = std::strtod(val.c_str(), &end);
+                if (val.empty() || *end != '\0') {
+                    throw "Invalid row weight!";
+                }
+            }
+            if (!(weight >= 0.0) || std::isinf(weight)) {
+                throw "Invalid row weight!";
+            }
+            weights[r.GetRowIndex()] = weight;
+        }
+    }
+    return weights;
+}
+
+void Graph::Coloring(const vector<vector<size_t>>& adj) {
+    ScopedPhase phase(&phase_times_, "coloring");
     size_t color = 0;
     bool done = false;
     while (!done) {
         done = true;
         for (size_t i = 0; i < nodes_.size(); i++) {
-            if (nodes_[i].color_ == -1) {
+            if (nodes_[i].color_ == kNoColor) {
                 nodes_[i].color_ = color;
-                vector<Edge> edges = nodes_[i].edges_;
-                for (int j = 0; j < edges.size(); j++) {
-                    if (nodes_[edges[j].v_].color_ == color) {
-                        nodes_[i].color_ = -1;
+                for (size_t v: adj[i]) {
+                    if (nodes_[v].color_ == color) {
+                        nodes_[i].color_ = kNoColor;
                         done = false;
                         break;
                     }
@@ -78,17 +304,16 @@ void Graph::Coloring() {
 
 size_t Graph::MostColor()
 {
-    unordered_map<size_t, size_t> counts;
+    // the heaviest color class of half nodes is left out of the cover
+    unordered_map<size_t, double> counts;
     for (size_t i = 0; i < nodes_.size(); i++) {
         //  cout << sum_graph.get_color(i) << endl;
         if (nodes_[i].lp_ == 0.5)
-            if (counts.count(nodes_[i].color_) == 0)
-                counts[nodes_[i].color_] = 1;
-            else
-                counts[nodes_[i].color_] += 1;
+            counts[nodes_[i].color_] += Weight(i);
     }
 
-    size_t max = 0, color = 0;
+    double max = 0.0;
+    size_t color = 0;
     for (auto iter = counts.begin(); iter != counts.end(); iter++) {
         // cout << iter->first << "," << iter->second << endl;
         if (iter->second > max) {
@@ -100,58 +325,122 @@ size_t Graph::MostColor()
     return color;
 }
 
-void Graph::LpSolver() {
-    int m = edges_.size();
-    int n = nodes_.size();
-initialize:
+vector<size_t> Graph::SolveExactComponents(vector<vector<size_t>>* adj) {
+    ScopedPhase phase(&phase_times_, "exact");
+    vector<size_t> vc;
+    vector<char> visited(nodes_.size(), 0);
+    vector<size_t> component, cover;
+    vector<size_t> local(nodes_.size());
+    vector<vector<size_t>> local_adj;
+    vector<double> local_weights;
+    for (size_t s = 0; s < nodes_.size(); s++) {
+        if (visited[s] || (*adj)[s].empty()) {
+            continue;
+        }
+        component.assign(1, s);
+        visited[s] = 1;
+        for (size_t head = 0; head < component.size(); head++) {
+            for (size_t v: (*adj)[component[head]]) {
+                if (!visited[v]) {
+                    visited[v] = 1;
+                    component.push_back(v);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < component.size(); i++) {
+            local[component[i]] = i;
+        }
+        local_adj.assign(component.size(), vector<size_t>());
+        for (size_t i = 0; i < component.size(); i++) {
+            for (size_t v: (*adj)[component[i]]) {
+                local_adj[i].push_back(local[v]);
+            }
+        }
+
+        local_weights.clear();
+        for (size_t u: component) {
+            local_weights.push_back(Weight(u));
+        }
+        ExactVertexCover exact(local_adj, weights_.empty() ? nullptr : &local_weights);
+        if (!exact.SolveClosedForm(&cover) && !exact.SolveBipartite(&cover)) {
+            if (component.size() > exact_threshold_) {
+                continue;
+            }
+            cover = exact.SolveBranchAndReduce();
+        }
+        for (size_t v: cover) {
+            vc.push_back(nodes_[component[v]].GetId());
+        }
+        for (size_t u: component) {
+            (*adj)[u].clear();
+        }
+    }
+    return vc;
+}
+
+void Graph::LpSolver(const vector<vector<size_t>>& adj) {
+    ScopedPhase phase(&phase_times_, "lp");
+    // columns only for nodes with an edge, numbered from 1 as glpk expects
+    vector<int> column(nodes_.size(), 0);
+    vector<std::pair<size_t, size_t>> rows;
+    int n = 0;
+    for (size_t u = 0; u < adj.size(); u++) {
+        if (!adj[u].empty()) {
+            column[u] = ++n;
+        }
+        for (size_t v: adj[u]) {
+            if (u < v) {
+                rows.emplace_back(u, v);
+            }
+        }
+    }
+    int m = rows.size();
+    // initialize
     glp_prob* lp;
     lp = glp_create_prob();
     glp_set_obj_dir(lp, GLP_MIN);
 
-auxiliary_variables_rows:
+    // auxiliary variables rows
     glp_add_rows(lp, m);
     for (int i = 1; i <= m; i++)
         glp_set_row_bnds(lp, i, GLP_LO, 1.0, 0.0);
 
-variables_columns:
+    // variables columns
     glp_add_cols(lp, n);
     for (int i = 1; i <= n; i++)
         glp_set_col_bnds(lp, i, GLP_DB, 0.0, 1.0);
 
-to_minimize:
-    for (int i = 1; i <= n; i++)
-        glp_set_obj_coef(lp, i, 1.0);
+    // to minimize
+    for (size_t u = 0; u < adj.size(); u++)
+        if (column[u] != 0)
+            glp_set_obj_coef(lp, column[u], Weight(u));
 
-constrant_matrix:
-    long long size = m * n;
+    // constraint matrix
+    // x_u + x_v >= 1, the two nonzeros of every edge row
+    long long size = 2LL * m;
     int* ia = new int[size + 1];
     int* ja = new int[size + 1];
     double* ar = new double[size + 1];
     for (int i = 1; i <= m; i++) {
-        Edge edge = edges_[i - 1];
-        for (int j = 1; j <= n; j++) {
-            int k = (i - 1) * n + j;
-            ia[k] = i;
-            ja[k] = j;
-            if (j - 1 == edge.u_ || j - 1 == edge.v_)
-                ar[k] = 1.0;
-            else
-                ar[k] = 0.0;
-        }
+        ia[2 * i - 1] = ia[2 * i] = i;
+        ja[2 * i - 1] = column[rows[i - 1].first];
+        ja[2 * i] = column[rows[i - 1].second];
+        ar[2 * i - 1] = ar[2 * i] = 1.0;
     }
     glp_load_matrix(lp, size, ia, ja, ar);
 
-calculate:
+    // calculate
     glp_simplex(lp, NULL);
     // glp_exact(lp, NULL);
 
-output:
+    // output
     // cout << glp_get_obj_val(lp) << endl;
-    for (int i = 1; i <= n; i++) {
-        nodes_[i - 1].lp_ = glp_get_col_prim(lp, i);
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        nodes_[i].lp_ = column[i] == 0 ? 0.0 : glp_get_col_prim(lp, column[i]);
     }
 
-cleanup:
+    // cleanup
     delete[] ia;
     delete[] ja;
     delete[] ar;
@@ -159,6 +448,7 @@ cleanup:
 }
 
 vector<size_t> Graph::EliminateTriangles() {
+    ScopedPhase phase(&phase_times_, "triangles");
     vector<size_t> vertexcover;
     size_t sum = 0;
     for (auto iter = edges_.begin(); iter != edges_.end();) {
@@ -216,34 +506,449 @@ void Graph::DelTriangle(size_t u, size_t v, size_t w) {
     }
 }
 
+std::shared_ptr<const Oracle> Graph::BuildOracle(const SubsetQuery& query) {
+    ScopedPhase phase(&phase_times_, "oracle");
+    if (query_cache_ != nullptr) {
+        return query_cache_->GetOracle(*table_, query);
+    }
+    return std::make_shared<const Oracle>(*table_, query);
+}
+
 double Graph::InconsistencyDegree(double epsilon, const SubsetQuery& query) {
-    Oracle oracle(*table_, query);
-    std::cout << "Oracle for query completed! Number of nodes in subgraph: " << oracle.NumberofNodesInSubgraph() << std::endl;
-    if (oracle.NumberofNodesInSubgraph() == 0) {
+    lca_stats_.Clear();
+    std::shared_ptr<const Oracle> oracle_ptr = BuildOracle(query);
+    const Oracle& oracle = *oracle_ptr;
+    if (verbose_) {
+        std::cout << "Oracle for query completed! Number of nodes in subgraph: " << oracle.NumberofNodesInSubgraph() << std::endl;
+    }
+    vector<double> cumulative = SampleWeights(oracle);
+    if (oracle.NumberofNodesInSubgraph() == 0 || (!cumulative.empty() && cumulative.back() == 0.0)) {
         return 0.0;
     }
-    double epsilon = query.GetEpsilon();
     size_t sample_number_threshold = ceil((double) 8 / (epsilon * epsilon));
+    size_t vc_size = SampleVertexCover(sample_number_threshold, oracle, cumulative);
+
+    if (verbose_) {
+        std::cout << "Vertex cover problem completed! The solution of vertex-cover: " << vc_size << std::endl;
+    }
+    ClearMemo();
+    return (double)(vc_size) / (double)(sample_number_threshold);
+}
+
+InconsistencyEstimate Graph::InconsistencyDegreeAdaptive(double epsilon, double delta, const SubsetQuery& query) {
+    if (!(epsilon > 0.0 && epsilon <= 1.0) || !(delta > 0.0 && delta < 1.0)) {
+        throw "Epsilon must lie in (0, 1] and delta in (0, 1)!";
+    }
+    lca_stats_.Clear();
+    std::shared_ptr<const Oracle> oracle_ptr = BuildOracle(query);
+    const Oracle& oracle = *oracle_ptr;
+    if (verbose_) {
+        std::cout << "Oracle for query completed! Number of nodes in subgraph: " << oracle.NumberofNodesInSubgraph() << std::endl;
+    }
+    InconsistencyEstimate result = {0.0, 0.0, 0.0, 0, LcaStats()};
+    vector<double> cumulative = SampleWeights(oracle);
+    if (oracle.NumberofNodesInSubgraph() == 0 || (!cumulative.empty() && cumulative.back() == 0.0)) {
+        return result;
+    }
+
+    // the interval is checked at geometrically spaced checkpoints, delta is split evenly
+    // among their tests and the final Hoeffding one (union bound) so the reported
+    // interval holds for the stopping time
+    size_t max_samples = ceil((double) 8 / (epsilon * epsilon));
+    size_t first_checkpoint = std::min<size_t>(32, max_samples);
+    size_t checkpoints = 1;
+    for (size_t t = first_checkpoint; t < max_samples; t *= 2) {
+        checkpoints++;
+    }
+    size_t tests = checkpoints + 1;
+    double log_term = log(3.0 * tests / delta);
+
+    ScopedPhase phase(&phase_times_, "sampling");
     size_t vc_size = 0;
-    for (size_t i = 0; i < sample_number_threshold; ++i) {
-        size_t node_id = oracle.SampleNode();
-        if (InVertexcover(node_id, oracle)) {
+    size_t next_checkpoint = first_checkpoint;
+    double half_width = 1.0;
+    size_t n = 0;
+    while (n < max_samples) {
+        if (ProbeSample(oracle, cumulative)) {
             vc_size++;
         }
+        n++;
+
+        if (n == next_checkpoint || n == max_samples) {
+            // empirical Bernstein bound (Audibert et al.), the sample variance of a
+            // Bernoulli proportion is p(1-p)
+            double p = (double) vc_size / (double) n;
+            half_width = sqrt(2.0 * p * (1.0 - p) * log_term / n) + 3.0 * log_term / n;
+            if (half_width <= epsilon) {
+                break;
+            }
+            next_checkpoint = std::min(next_checkpoint * 2, max_samples);
+        }
     }
 
-    std::cout << "Vertex cover problem completed! The solution of vertex-cover: " << vc_size << std::endl;
+    // at the worst-case sample size Hoeffding may be the tighter of the two bounds
+    if (n == max_samples) {
+        half_width = std::min(half_width, sqrt(log(2.0 * tests / delta) / (2.0 * n)));
+    }
+
+    if (verbose_) {
+        std::cout << "Vertex cover problem completed! The solution of vertex-cover: " << vc_size << ", samples: " << n << std::endl;
+    }
+    ClearMemo();
+
+    result.estimate_ = (double) vc_size / (double) n;
+    result.lower_ = std::max(0.0, result.estimate_ - half_width);
+    result.upper_ = std::min(1.0, result.estimate_ + half_width);
+    result.samples_ = n;
+    result.stats_ = lca_stats_;
+    return result;
+}
+
+vector<double> Graph::InconsistencyDegreeBatch(double epsilon, const vector<SubsetQuery>& queries) {
+    lca_stats_.Clear();
+    vector<Oracle> oracles;
+    {
+        ScopedPhase phase(&phase_times_, "oracle");
+        oracles = Oracle::BuildBatch(*table_, queries);
+    }
+    if (verbose_) {
+        std::cout << "Oracles for " << queries.size() << " queries completed!" << std::endl;
+    }
+
+    // group queries by subgraph membership, the first query of a group does the sampling
+    unordered_map<size_t, vector<size_t>> groups;
+    vector<double> ret(queries.size(), 0.0);
+    vector<size_t> representative(queries.size());
+    size_t distinct = 0;
+    size_t sample_number_threshold = ceil((double) 8 / (epsilon * epsilon));
+    for (size_t i = 0; i < oracles.size(); i++) {
+        representative[i] = i;
+        vector<size_t>& candidates = groups[oracles[i].GetMembership().Hash()];
+        for (size_t j: candidates) {
+            if (oracles[j].GetMembership() == oracles[i].GetMembership()) {
+                representative[i] = j;
+                break;
+            }
+        }
+        if (representative[i] != i) {
+            ret[i] = ret[representative[i]];
+            continue;
+        }
+        candidates.push_back(i);
+        distinct++;
+
+        vector<double> cumulative = SampleWeights(oracles[i]);
+        if (oracles[i].NumberofNodesInSubgraph() != 0 && (cumulative.empty() || cumulative.back() != 0.0)) {
+            size_t vc_size = SampleVertexCover(sample_number_threshold, oracles[i], cumulative);
+            ret[i] = (double)(vc_size) / (double)(sample_number_threshold);
+        }
+        // the memo only holds for the subgraph it was computed on
+        ClearMemo();
+    }
+
+    if (verbose_) {
+        std::cout << "Vertex cover problem completed for " << distinct << " distinct subgraphs!" << std::endl;
+    }
+    return ret;
+}
+
+vector<double> Graph::SampleWeights(const Oracle& oracle) {
+    LoadWeights();
+    if (weights_.empty()) {
+        return vector<double>();
+    }
+    return oracle.CumulativeWeights(weights_);
+}
+
+size_t Graph::SampleVertexCover(size_t sample_number, const Oracle& oracle, const vector<double>& cumulative) {
+    ScopedPhase phase(&phase_times_, "sampling");
+    size_t vc_size = 0;
+    for (size_t i = 0; i < sample_number; ++i) {
+        if (ProbeSample(oracle, cumulative)) {
+            vc_size++;
+        }
+    }
+    return vc_size;
+}
+
+Graph::EdgeList Graph::Neighbours(size_t node_id) {
+    if (!implicit_) {
+        // non-owning view of the materialized adjacency list
+        return EdgeList(std::shared_ptr<void>(), &nodes_[node_id].edges_);
+    }
+    EdgeList edges;
+    if (!neighbour_cache_.Get(node_id, &edges)) {
+        edges = GenerateNeighbours(node_id);
+        neighbour_cache_.Put(node_id, edges);
+    }
+    return edges;
+}
+
+Graph::EdgeList Graph::GenerateNeighbours(size_t node_id) {
+    std::shared_ptr<vector<Edge>> edges = std::make_shared<vector<Edge>>();
+    if (node_id + 1 >= partition_offsets_.size()) {
+        return edges;
+    }
+    for (size_t m = partition_offsets_[node_id]; m < partition_offsets_[node_id + 1]; m++) {
+        const ConflictGroup& partition = partitions_[partition_memberships_[m].first];
+        uint32_t rhs_class = partition.GetRhsClass(partition_memberships_[m].second);
+        for (size_t i = 0; i < partition.Size(); i++) {
+            if (partition.GetRhsClass(i) != rhs_class) {
+                size_t v = partition.GetMember(i);
+                edges->emplace_back(node_id, v, 0, ranker_.Rank(node_id, v));
+            }
+        }
+    }
+    std::sort(edges->begin(), edges->end());
+    // a pair conflicting under several FDs is one edge
+    edges->erase(std::unique(edges->begin(), edges->end(), [](const Edge& a, const Edge& b) {
+        return a.v_ == b.v_ && a.ranking_ == b.ranking_;
+    }), edges->end());
+    for (Edge& edge: *edges) {
+        edge.edge_id_ = VirtualEdgeId(node_id, edge.v_);
+    }
+    return edges;
+}
+
+EdgeId Graph::VirtualEdgeId(size_t u, size_t v) {
+    // the top bit keeps these ids apart from the ids of materialized edges
+    static const EdgeId kVirtualEdgeBit = (EdgeId)1 << (sizeof(EdgeId) * 8 - 1);
+    std::pair<size_t, size_t> key(std::min(u, v), std::max(u, v));
+    auto iter = virtual_edge_ids_.find(key);
+    if (iter == virtual_edge_ids_.end()) {
+        if (virtual_edge_ids_.size() >= (size_t)(kVirtualEdgeBit - 1)) {
+            throw "Graph exceeds the edge id width, build with DCR_64BIT_IDS!";
+        }
+        iter = virtual_edge_ids_.emplace(key, kVirtualEdgeBit | virtual_edge_ids_.size()).first;
+    }
+    return iter->second;
+}
+
+std::shared_ptr<GroupNeighbourOrder> Graph::GroupNeighbours(size_t node_id) {
+    auto iter = node_groups_.find(node_id);
+    if (iter == node_groups_.end()) {
+        return nullptr;
+    }
+    std::shared_ptr<GroupNeighbourOrder> order;
+    if (!group_cache_.Get(node_id, &order)) {
+        vector<std::pair<const ConflictGroup*, size_t>> memberships;
+        for (const std::pair<size_t, size_t>& m: iter->second) {
+            memberships.emplace_back(&groups_[m.first], m.second);
+        }
+        order = std::make_shared<GroupNeighbourOrder>(node_id, memberships, ranker_);
+        group_cache_.Put(node_id, order);
+    }
+    return order;
+}
+
+vector<Graph::LhsPartition> Graph::PartitionByLhs() {
+    const vector<FunctionalDependency>& fds = table_->GetFunctionalDependencies();
+    vector<vector<size_t>> lhs_cols, rhs_cols;
+    for (const FunctionalDependency& fd: fds) {
+        lhs_cols.push_back(fd.GetLeftHandColumns(table_->GetTableAttrbutes()));
+        rhs_cols.push_back(fd.GetRightHandColumns(table_->GetTableAttrbutes()));
+    }
+    auto append_key = [](const RecordView& r, const vector<size_t>& cols, string* key) {
+        for (size_t col: cols) {
+            std::string_view val = r.GetField(col);
+            key->append(val.data(), val.size());
+            *key += '\x1f';
+        }
+    };
+    // each scan partition is keyed on its own thread, merging in partition order keeps
+    // rows in table order
+    vector<std::unique_ptr<TableIterator>> iters = table_->GetPartitionedIterators();
+    vector<vector<LhsPartition>> partial(iters.size(), vector<LhsPartition>(fds.size()));
+    ParallelFor(iters.size(), [&](size_t p) {
+        RowBatch batch;
+        string lhs, rhs;
+        while (iters[p]->NextBatch(&batch, RowBatch::kDefaultRows) != 0) {
+            for (size_t i = 0; i < batch.Size(); i++) {
+                RecordView r = batch.GetRow(i);
+                for (size_t f = 0; f < fds.size(); f++) {
+                    lhs.clear();
+                    rhs.clear();
+                    append_key(r, lhs_cols[f], &lhs);
+                    append_key(r, rhs_cols[f], &rhs);
+                    partial[p][f][lhs].emplace_back(r.GetRowIndex(), rhs);
+                }
+            }
+        }
+    });
+    vector<LhsPartition> partitions = std::move(partial[0]);
+    for (size_t p = 1; p < partial.size(); p++) {
+        for (size_t f = 0; f < fds.size(); f++) {
+            for (auto& kv: partial[p][f]) {
+                vector<std::pair<size_t, string>>& rows = partitions[f][kv.first];
+                rows.insert(rows.end(), std::make_move_iterator(kv.second.begin()),
+                        std::make_move_iterator(kv.second.end()));
+            }
+        }
+    }
+
+    return partitions;
+}
+
+void Graph::InitializeGroups() {
+    size_t total_num = table_->GetRowIndexBound();
+    for (size_t i = 0; i < total_num; i++) {
+        AddNode(i);
+    }
+
+    vector<LhsPartition> partitions = PartitionByLhs();
+    std::unordered_set<std::pair<size_t, size_t>, PairHash> added;
+    for (auto& partition: partitions) {
+        for (auto& kv: partition) {
+            vector<std::pair<size_t, string>>& rows = kv.second;
+            if (rows.size() >= group_threshold_) {
+                unordered_map<string, uint32_t> rhs_classes;
+                ConflictGroup group;
+                for (auto& row: rows) {
+                    auto cls = rhs_classes.emplace(row.second, (uint32_t)rhs_classes.size()).first;
+                    group.AddMember(row.first, cls->second);
+                }
+                if (rhs_classes.size() < 2) {
+                    continue;
+                }
+                for (size_t pos = 0; pos < group.Size(); pos++) {
+                    node_groups_[group.GetMember(pos)].emplace_back(groups_.size(), pos);
+                }
+                groups_.push_back(std::move(group));
+                continue;
+            }
+            for (size_t i = 0; i < rows.size(); i++) {
+                for (size_t j = i + 1; j < rows.size(); j++) {
+                    if (rows[i].second == rows[j].second) {
+                        continue;
+                    }
+                    size_t u = std::min(rows[i].first, rows[j].first);
+                    size_t v = std::max(rows[i].first, rows[j].first);
+                    if (added.emplace(u, v).second) {
+                        AddEdge(u, v, NextRanking(u, v));
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        nodes_[i].SortEdge();
+    }
+}
+
+void Graph::InitializeImplicit() {
+    size_t total_num = table_->GetRowIndexBound();
+    if (total_num != 0) {
+        CheckNodeId(total_num - 1);
+    }
+
+    // only partitions with two RHS values or more hold conflicts
+    vector<size_t> membership_num(total_num, 0);
+    for (auto& partition: PartitionByLhs()) {
+        for (auto& kv: partition) {
+            unordered_map<string, uint32_t> rhs_classes;
+            ConflictGroup group;
+            for (auto& row: kv.second) {
+                auto cls = rhs_classes.emplace(row.second, (uint32_t)rhs_classes.size()).first;
+                group.AddMember(row.first, cls->second);
+            }
+            if (rhs_classes.size() < 2) {
+                continue;
+            }
+            for (size_t pos = 0; pos < group.Size(); pos++) {
+                membership_num[group.GetMember(pos)]++;
+            }
+            partitions_.push_back(std::move(group));
+        }
+    }
+
+    partition_offsets_.assign(total_num + 1, 0);
+    for (size_t u = 0; u < total_num; u++) {
+        partition_offsets_[u + 1] = partition_offsets_[u] + membership_num[u];
+    }
+    partition_memberships_.resize(partition_offsets_[total_num]);
+    vector<size_t> next(partition_offsets_.begin(), partition_offsets_.end() - 1);
+    for (size_t p = 0; p < partitions_.size(); p++) {
+        for (size_t pos = 0; pos < partitions_[p].Size(); pos++) {
+            partition_memberships_[next[partitions_[p].GetMember(pos)]++] = std::make_pair(p, pos);
+        }
+    }
+}
+
+Graph::NeighbourIterator::NeighbourIterator(Graph* graph, size_t node_id): graph_(graph), node_id_(node_id),
+        edges_(graph->Neighbours(node_id)), pos_(0), group_iter_(graph->GroupNeighbours(node_id)),
+        has_current_(false), from_list_(false) {
+    Settle();
+}
+
+void Graph::NeighbourIterator::Next() {
+    if (from_list_) {
+        pos_++;
+    } else {
+        group_iter_.Next();
+    }
+    Settle();
+}
+
+void Graph::NeighbourIterator::Settle() {
+    bool in_list = pos_ < edges_->size();
+    has_current_ = in_list || group_iter_.HasNext();
+    if (!has_current_) {
+        return;
+    }
+    if (group_iter_.HasNext()) {
+        const std::pair<EdgeRank, size_t>& head = group_iter_.Peek();
+        // a pair conflicting in a group and as an explicit edge is reported once
+        if (in_list && (*edges_)[pos_].v_ == head.second) {
+            group_iter_.Next();
+            Settle();
+            return;
+        }
+        Edge group_edge(node_id_, head.second, 0, head.first);
+        if (!in_list || group_edge < (*edges_)[pos_]) {
+            group_edge.edge_id_ = graph_->VirtualEdgeId(node_id_, head.second);
+            current_ = group_edge;
+            from_list_ = false;
+            return;
+        }
+    }
+    current_ = (*edges_)[pos_];
+    from_list_ = true;
+}
+
+void Graph::ClearMemo() {
     matching_.clear();
     vertex_cover_.clear();
-    return (double)(vc_size) / (double)(sample_number_threshold);
+    duals_.clear();
+    // cached lists carry virtual edge ids, both go so the id map does not grow across queries
+    virtual_edge_ids_.clear();
+    neighbour_cache_.Clear();
+}
+
+bool Graph::ProbeSample(const Oracle& oracle, const vector<double>& cumulative) {
+    size_t node_id = cumulative.empty() ? oracle.SampleNode() : oracle.SampleNode(cumulative);
+#ifndef DCR_DISABLE_STATS
+    size_t calls_before = lca_stats_.in_matching_calls_;
+#endif
+    bool ret = InVertexcover(node_id, oracle);
+    DCR_STAT(lca_stats_.RecordSample(lca_stats_.in_matching_calls_ - calls_before));
+    return ret;
 }
 
 bool Graph::InVertexcover(size_t node_id, const Oracle& oracle) {
     if (vertex_cover_.count(node_id) != 0) {
+        DCR_STAT(lca_stats_.memo_hits_++);
         return vertex_cover_[node_id];
     }
-    const Node& node = nodes_[node_id];
-    for (const Edge& edge : node.edges_) {
+    DCR_STAT(lca_stats_.memo_misses_++);
+    if (!weights_.empty()) {
+        bool ret = Residual(node_id, nullptr, oracle) == 0.0;
+        vertex_cover_[node_id] = ret;
+        return ret;
+    }
+    for (NeighbourIterator iter(this, node_id); iter.HasNext(); iter.Next()) {
+        const Edge& edge = iter.Peek();
+        DCR_STAT(lca_stats_.oracle_checks_++);
         if (oracle.InSubgraph(edge.v_)) {
             if (InMatching(node_id, edge, oracle)) {
                 vertex_cover_[node_id] = true;
@@ -256,34 +961,87 @@ bool Graph::InVertexcover(size_t node_id, const Oracle& oracle) {
 }
 
 bool Graph::InMatching(size_t u, const Edge& edge, const Oracle& oracle) {
+    DCR_STAT(lca_stats_.in_matching_calls_++);
     if (matching_.count(edge.edge_id_) != 0) {
+        DCR_STAT(lca_stats_.memo_hits_++);
         return matching_[edge.edge_id_];
     }
+    DCR_STAT(lca_stats_.memo_misses_++);
+    DCR_STAT(lca_depth_++);
+    DCR_STAT(lca_stats_.max_depth_ = std::max(lca_stats_.max_depth_, lca_depth_));
 
-    const Node& node_u = nodes_[u];
-    const Node& node_v = nodes_[edge.v_];
-    int k_1 = 0, k_2 = 0;
-    while (node_u.edges_[k_1] < edge || node_v.edges_[k_2] < edge) {
-        if (node_u.edges_[k_1] < node_v.edges_[k_2]) {
-            if (oracle.InSubgraph(node_u.edges_[k_1].v_)) {
-                if (InMatching(u, node_u.edges_[k_1], oracle)) {
+    // the iterators hold their adjacency lists for the whole merge, an implicit graph may
+    // evict them from the neighbour cache during recursion
+    NeighbourIterator iter_u(this, u);
+    NeighbourIterator iter_v(this, edge.v_);
+    while ((iter_u.HasNext() && iter_u.Peek() < edge) || (iter_v.HasNext() && iter_v.Peek() < edge)) {
+        if (iter_u.HasNext() && iter_u.Peek() < edge && (!iter_v.HasNext() || !(iter_v.Peek() < edge) ||
+                iter_u.Peek() < iter_v.Peek())) {
+            DCR_STAT(lca_stats_.edges_scanned_++);
+            DCR_STAT(lca_stats_.oracle_checks_++);
+            if (oracle.InSubgraph(iter_u.Peek().v_)) {
+                if (InMatching(u, iter_u.Peek(), oracle)) {
                     matching_[edge.edge_id_] = false;
+                    DCR_STAT(lca_depth_--);
                     return false;
                 }
             }
-            k_1++;
+            iter_u.Next();
         } else {
-            if (oracle.InSubgraph(node_v.edges_[k_2].v_)) {
-                if (InMatching(edge.v_, node_v.edges_[k_2], oracle)) {
+            DCR_STAT(lca_stats_.edges_scanned_++);
+            DCR_STAT(lca_stats_.oracle_checks_++);
+            if (oracle.InSubgraph(iter_v.Peek().v_)) {
+                if (InMatching(edge.v_, iter_v.Peek(), oracle)) {
                     matching_[edge.edge_id_] = false;
+                    DCR_STAT(lca_depth_--);
                     return false;
                 }
             }
-            k_2++;
+            iter_v.Next();
         }
     }
     matching_[edge.edge_id_] = true;
+    DCR_STAT(lca_depth_--);
     return true;
 }
 
+double Graph::Residual(size_t u, const Edge* before, const Oracle& oracle) {
+    // the duals are subtracted in the same order on every call, so the residual of the
+    // endpoint an edge made tight comes out exactly 0
+    double residual = Weight(u);
+    for (NeighbourIterator iter(this, u); iter.HasNext() && residual > 0.0; iter.Next()) {
+        const Edge& edge = iter.Peek();
+        if (before != nullptr && !(edge < *before)) {
+            break;
+        }
+        DCR_STAT(lca_stats_.edges_scanned_++);
+        DCR_STAT(lca_stats_.oracle_checks_++);
+        if (oracle.InSubgraph(edge.v_)) {
+            residual -= EdgeDual(u, edge, oracle);
+        }
+    }
+    return residual;
+}
+
+double Graph::EdgeDual(size_t u, const Edge& edge, const Oracle& oracle) {
+    DCR_STAT(lca_stats_.in_matching_calls_++);
+    auto iter = duals_.find(edge.edge_id_);
+    if (iter != duals_.end()) {
+        DCR_STAT(lca_stats_.memo_hits_++);
+        return iter->second;
+    }
+    DCR_STAT(lca_stats_.memo_misses_++);
+    DCR_STAT(lca_depth_++);
+    DCR_STAT(lca_stats_.max_depth_ = std::max(lca_stats_.max_depth_, lca_depth_));
+
+    double dual = 0.0;
+    double residual_u = Residual(u, &edge, oracle);
+    if (residual_u > 0.0) {
+        dual = std::min(residual_u, Residual(edge.v_, &edge, oracle));
+    }
+    duals_[edge.edge_id_] = dual;
+    DCR_STAT(lca_depth_--);
+    return dual;
+}
+
 }  // namespace dcr
\ No newline at end of file
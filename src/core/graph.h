@@ -2,24 +2,105 @@
 #define DCR_CORE_GRAPH_H_
 
 #include <cstdio>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 #include <unordered_map>
+#include "core/conflict_group.h"
+#include "core/edge_ranker.h"
+#include "core/lca_stats.h"
+#include "core/lru_cache.h"
+#include "core/oracle.h"
+#include "core/phase_timer.h"
+#include "core/query_cache.h"
 #include "core/subset_query.h"
+#include "core/types.h"
 
 namespace dcr {
 
 class SubsetQuery;
 
+// Result of a sequential (early-stopping) inconsistency estimation: the point estimate,
+// a confidence interval holding with probability at least 1 - delta, and the number of
+// sampled nodes that were probed with the LCA.
+struct InconsistencyEstimate {
+    double estimate_;
+    double lower_;
+    double upper_;
+    size_t samples_;
+    LcaStats stats_;
+};
+
+struct GraphOptions {
+    size_t k_quasi_count_ = 0;
+    RankingMode ranking_mode_ = RankingMode::kRandomSequence;
+    // 0 seeds from the clock; fix it to reproduce kKeyedHash rankings across runs
+    uint64_t seed_ = 0;
+    // implicit graphs keep the LHS partitions of one table scan and generate a node's
+    // neighbours from them on first probe instead of materializing all edges, only
+    // InconsistencyDegree* is supported on them
+    bool implicit_ = false;
+    size_t neighbour_cache_capacity_ = 1 << 16;
+    // LHS groups with at least this many rows are kept as a ConflictGroup instead of
+    // pairwise edges (0 disables), only InconsistencyDegree* is supported on them
+    size_t group_threshold_ = 0;
+    // group members' neighbour orders kept between probes, in nodes; a cached order holds
+    // up to a group's size of entries
+    size_t group_cache_capacity_ = 1 << 12;
+    // oracles of re-issued queries are taken from here instead of scanning the table,
+    // not owned and may be shared by several graphs
+    QueryCache* query_cache_ = nullptr;
+    // VertexCover* solves components of at most this many nodes exactly by branch and
+    // reduce instead of through the LP (0 disables); cliques, stars, paths, cycles and
+    // bipartite components are solved exactly at any size
+    size_t exact_threshold_ = 32;
+    // VertexCover* shrinks the graph with the VertexCoverKernel reduction rules first
+    bool kernelize_ = true;
+    // Repair cost of a row, weight_fn_ if set and otherwise the numeric column
+    // weight_attr_; every row costs 1 without either. Weighted graphs minimize the cover
+    // weight and InconsistencyDegree* estimates the weight fraction of the subgraph.
+    std::string weight_attr_;
+    std::function<double(const RecordView&)> weight_fn_;
+    // progress messages on stdout
+    bool verbose_ = true;
+};
 
 class Graph {
 public:
+    // exposes the private phases to the benchmark suite
+    friend class GraphBench;
 
     Graph() = delete;
 
-	Graph(Table *table, k_quasi_count=0): table_(table),k_quasi_count_(k_quasi_count) {
-		unsigned int seed = (unsigned int)time(NULL);
-		rsu_ = new RandomSequenceOfUnique(seed, seed + 1);
-        Initialize();
+	Graph(Table *table, size_t k_quasi_count=0): Graph(table, QuasiCountOptions(k_quasi_count)) {}
+
+	Graph(Table *table, const GraphOptions& options): k_quasi_count_(options.k_quasi_count_), table_(table),
+            ranking_mode_(options.ranking_mode_), rsu_(nullptr), implicit_(options.implicit_),
+            neighbour_cache_(options.neighbour_cache_capacity_), group_threshold_(options.group_threshold_),
+            group_cache_(options.group_cache_capacity_),
+            query_cache_(options.query_cache_), exact_threshold_(options.exact_threshold_),
+            kernelize_(options.kernelize_), weight_attr_(options.weight_attr_), weight_fn_(options.weight_fn_),
+            verbose_(options.verbose_) {
+		uint64_t seed = options.seed_ != 0 ? options.seed_ : (uint64_t)time(NULL);
+		if (implicit_ || group_threshold_ != 0) {
+			// lazily generated lists must rank an edge identically from both endpoints
+			ranking_mode_ = RankingMode::kKeyedHash;
+		}
+		if (ranking_mode_ == RankingMode::kRandomSequence) {
+			rsu_ = new RandomSequenceOfUnique((unsigned int)seed, (unsigned int)seed + 1);
+		} else {
+			ranker_ = EdgeRanker(seed);
+		}
+		ScopedPhase phase(&phase_times_, "graph build");
+		if (implicit_) {
+			InitializeImplicit();
+		} else if (group_threshold_ != 0) {
+			InitializeGroups();
+		} else {
+            Initialize();
+		}
 	}
 
     Graph(const Graph&) = delete;
@@ -34,10 +115,55 @@ public:
 
     std::vector<size_t> VertexCoverTelp();
 
+    // Bar-Yehuda-Even primal-dual 2-approximation in one pass over the edges, the cover of
+    // a maximal matching on unweighted graphs.
+    std::vector<size_t> VertexCoverPrimalDual();
+
+    // Unweighted 2-approximation from the maximal matching that takes edges in rank order,
+    // the one the LCA simulates, computed in rounds on threads threads: an edge joins the
+    // matching once it is the lowest ranked live edge at both of its endpoints.
+    std::vector<size_t> VertexCoverPrimalDualParallel(size_t threads);
+
     // std::vector<size_t> VertexCoverQtlp(int k, double epsilon);
 
     double InconsistencyDegree(double epsilon, const SubsetQuery&);
 
+    // stops sampling once the empirical Bernstein interval is within epsilon, never draws
+    // more than the ceil(8 / epsilon^2) samples of InconsistencyDegree; epsilon in (0, 1]
+    // and delta in (0, 1)
+    InconsistencyEstimate InconsistencyDegreeAdaptive(double epsilon, double delta, const SubsetQuery&);
+
+    // builds the oracles of all queries in one table scan; queries selecting the same
+    // subgraph share one LCA run and therefore one estimate
+    std::vector<double> InconsistencyDegreeBatch(double epsilon, const std::vector<SubsetQuery>& queries);
+
+    // one node per row index below Table::GetRowIndexBound()
+    inline size_t GetNodeNum() const {
+        return nodes_.size();
+    }
+
+    inline size_t GetEdgeNum() const {
+        return edges_.size();
+    }
+
+    inline bool IsWeighted() const {
+        return weight_fn_ || !weight_attr_.empty();
+    }
+
+    // total weight of a cover, its size on unweighted graphs
+    double GetCoverWeight(const std::vector<size_t>& vc);
+
+    // wall time of construction, coloring, lp, rounding, triangles, oracle and sampling,
+    // accumulated over all calls
+    inline const PhaseTimes& GetPhaseTimes() const {
+        return phase_times_;
+    }
+
+    // counters of the last InconsistencyDegree* call, zero with DCR_DISABLE_STATS
+    inline const LcaStats& GetLcaStats() const {
+        return lca_stats_;
+    }
+
     std::string ToString() {
         std::stringstream ss;
         ss << "The graph contains vertex num: " << nodes_.size() << ", edge num: " << edges_.size();
@@ -46,16 +172,34 @@ public:
 
     void PersistOSR(std::vector<size_t>& except_idxs);
 
+    // adds a conflict edge after construction, keeping adjacency lists in rank order; an
+    // existing edge is left as is, self-loops and implicit or grouped graphs throw
+    void InsertEdge(size_t u, size_t v);
+
 private:
 
+    // color_ of nodes the coloring has not reached
+    static constexpr NodeId kNoColor = std::numeric_limits<NodeId>::max();
+
+    static GraphOptions QuasiCountOptions(size_t k_quasi_count) {
+        GraphOptions options;
+        options.k_quasi_count_ = k_quasi_count;
+        return options;
+    }
+
     class Edge {
     public:
-        Edge(size_t u, size_t v, size_t edge_id, size_t ranking): u_(u), v_(v), edge_id_(edge_id), ranking_(ranking) {}
+        Edge(NodeId u, NodeId v, EdgeId edge_id, EdgeRank ranking): u_(u), v_(v), edge_id_(edge_id), ranking_(ranking) {}
 
         Edge() = default;
 
         bool operator < (const Edge& other) const {
-            return ranking_ < other.ranking_;
+            if (ranking_ != other.ranking_) {
+                return ranking_ < other.ranking_;
+            }
+            // hashed ranks may collide, break ties on the unordered endpoint pair
+            return std::make_pair(std::min(u_, v_), std::max(u_, v_)) <
+                    std::make_pair(std::min(other.u_, other.v_), std::max(other.u_, other.v_));
         }
 
         bool operator==(const Edge& other) const {
@@ -66,20 +210,20 @@ private:
             return edge_id_;
         }
 
-        size_t u_;
-        size_t v_;
-        size_t edge_id_;
-        size_t ranking_;
+        NodeId u_;
+        NodeId v_;
+        EdgeId edge_id_;
+        EdgeRank ranking_;
     };
 
 
     class Node {
     public:
-        Node(size_t node_id, size_t color = -1, double lp = -1.0, size_t k_quasi = 0): node_id_(node_id), color_(color), lp_(lp), k_quasi_(k_quasi) {}
+        Node(NodeId node_id, NodeId color = kNoColor, double lp = -1.0): edges_(), lp_(lp), node_id_(node_id), color_(color) {}
 
         Node() = default;
 
-        void AddEdge(size_t v_node_id, size_t edge_id, size_t ranking) {
+        void AddEdge(NodeId v_node_id, EdgeId edge_id, EdgeRank ranking) {
             edges_.emplace_back(node_id_, v_node_id, edge_id, ranking);
         }
 
@@ -87,8 +231,9 @@ private:
             std::sort(edges_.begin(), edges_.end());
         }
 
-        Edge GetEdge(int v_node_id) {
+        Edge GetEdge(NodeId v_node_id) {
             for (Edge e : edges_) if (e.v_ == v_node_id) return e;
+            throw "No edge to the node!";
         }
 
         size_t EdgeSize() {
@@ -111,47 +256,126 @@ private:
         }
 
         bool operator==(const Node& other) const {
-            return this.node_id_ == other.node_id_;
+            return this->node_id_ == other.node_id_;
         }
 
         size_t GetId() {
             return node_id_;
         }
 
-        size_t node_id_;
+        // widest members first so a node carries no padding
         std::vector<Edge> edges_;
-        size_t color_;
         double lp_;
-        int k_quasi_;
+        NodeId node_id_;
+        NodeId color_;
     };
 
     size_t k_quasi_count_;
 
+    PhaseTimes phase_times_;
+
+    LcaStats lca_stats_;
+    size_t lca_depth_ = 0;
+
     std::vector<Node> nodes_;
     std::vector<Edge> edges_;
+    size_t next_edge_id_ = 0;
 
     Table* table_;
 
     std::unordered_map<size_t, bool> vertex_cover_;
     std::unordered_map<size_t, bool> matching_;
+    // duals of the weighted LCA by edge id
+    std::unordered_map<size_t, double> duals_;
 
+    RankingMode ranking_mode_;
     RandomSequenceOfUnique* rsu_;
+    EdgeRanker ranker_;
+
+    typedef std::shared_ptr<const std::vector<Edge>> EdgeList;
+
+    struct PairHash {
+        size_t operator()(const std::pair<size_t, size_t>& p) const {
+            return std::hash<size_t>()(p.first * 0x9e3779b97f4a7c15ULL ^ p.second);
+        }
+    };
+
+    bool implicit_;
+    LruCache<size_t, EdgeList> neighbour_cache_;
+    // LHS partitions with conflicts of an implicit graph, and the (partition, position)
+    // memberships of node u at [partition_offsets_[u], partition_offsets_[u + 1])
+    std::vector<ConflictGroup> partitions_;
+    std::vector<size_t> partition_offsets_;
+    std::vector<std::pair<size_t, size_t>> partition_memberships_;
+    // edges outside edges_ (implicit or inside a conflict group) get their id on first
+    // sight so memo entries survive cache eviction, until ClearMemo()
+    std::unordered_map<std::pair<size_t, size_t>, EdgeId, PairHash> virtual_edge_ids_;
+
+    size_t group_threshold_;
+    std::vector<ConflictGroup> groups_;
+    // (group index, position in group) of every node belonging to a conflict group
+    std::unordered_map<size_t, std::vector<std::pair<size_t, size_t>>> node_groups_;
+    LruCache<size_t, std::shared_ptr<GroupNeighbourOrder>> group_cache_;
+
+    QueryCache* query_cache_;
+
+    size_t exact_threshold_;
+    bool kernelize_;
+
+    std::string weight_attr_;
+    std::function<double(const RecordView&)> weight_fn_;
+    // by row index, empty until LoadWeights() and on unweighted graphs
+    std::vector<double> weights_;
+
+    bool verbose_;
+
+    // merges a node's adjacency list with its conflict group neighbours in rank order
+    class NeighbourIterator {
+    public:
+        NeighbourIterator(Graph* graph, size_t node_id);
+
+        inline bool HasNext() const {
+            return has_current_;
+        }
+
+        inline const Edge& Peek() const {
+            return current_;
+        }
+
+        void Next();
+
+    private:
+        void Settle();
+
+        Graph* graph_;
+        size_t node_id_;
+        EdgeList edges_;
+        size_t pos_;
+        GroupNeighbourIterator group_iter_;
+        Edge current_;
+        bool has_current_;
+        bool from_list_;
+    };
 
     void Initialize() {
-        size_t total_num = table_->GetTotalRowNum();
+        // node ids are row indexes, rows missing below the bound are isolated nodes
+        size_t total_num = table_->GetRowIndexBound();
         for (size_t i = 0; i < total_num; i++) {
             AddNode(i);
         }
 
-        iter = table_->GetIterator();
-        while (iter.HasNext()) {
-            Record r = iter.Next();
-            size_t r_node_idx = r.GetRowIndex();
-
-            std::vector<size_t> conflict_nodes_idx = table_->FindConflict(r);
-            for (size_t node_idx: confict_nodes_idx) {
-                if (node_idx > r_node_idx) {
-                    AddEdge(r_node_idx, node_idx, edges_.size(), rsu_->Next());
+        std::unique_ptr<TableIterator> iter = table_->GetIterator();
+        RowBatch batch;
+        while (iter->NextBatch(&batch, RowBatch::kDefaultRows) != 0) {
+            for (size_t i = 0; i < batch.Size(); i++) {
+                RecordView r = batch.GetRow(i);
+                size_t r_node_idx = r.GetRowIndex();
+
+                std::vector<size_t> conflict_nodes_idx = table_->FindConflict(r);
+                for (size_t node_idx: conflict_nodes_idx) {
+                    if (node_idx > r_node_idx) {
+                        AddEdge(r_node_idx, node_idx, NextRanking(r_node_idx, node_idx));
+                    }
                 }
             }
         }
@@ -161,21 +385,75 @@ private:
         }
     }
 
+    typedef std::unordered_map<std::string, std::vector<std::pair<size_t, std::string>>> LhsPartition;
+
+    // per FD: LHS value -> (row, RHS value) of every row with that LHS value, in one scan
+    std::vector<LhsPartition> PartitionByLhs();
+
+    // partitions every FD by its LHS value in one scan, large partitions become groups
+    void InitializeGroups();
+
+    void InitializeImplicit();
+
+    EdgeRank NextRanking(size_t u, size_t v) {
+        if (ranking_mode_ == RankingMode::kKeyedHash) {
+            return ranker_.Rank(u, v);
+        }
+        return rsu_->Next();
+    }
+
+    static void CheckNodeId(size_t node_id) {
+        if (node_id > std::numeric_limits<NodeId>::max()) {
+            throw "Graph exceeds the node id width, build with DCR_64BIT_IDS!";
+        }
+    }
+
     void AddNode(size_t node_id) {
+        CheckNodeId(node_id);
         nodes_.emplace_back(node_id);
     }
 
-    void AddEdge(size_t u, size_t v, size_t edge_id, size_t ranking) {
+    // ids are never reused, edges_ shrinks when triangles are eliminated
+    EdgeId NextEdgeId() {
+        if (next_edge_id_ >= std::numeric_limits<EdgeId>::max() >> 1) {
+            throw "Graph exceeds the edge id width, build with DCR_64BIT_IDS!";
+        }
+        return next_edge_id_++;
+    }
+
+    void AddEdge(size_t u, size_t v, EdgeRank ranking) {
+        EdgeId edge_id = NextEdgeId();
         nodes_[u].AddEdge(v, edge_id, ranking);
         nodes_[v].AddEdge(u, edge_id, ranking);
         edges_.emplace_back(u, v, edge_id, ranking);
     }
 
-    void Coloring();
+    // kernelizes the graph, solves what ExactVertexCover can and rounds the LP relaxation
+    // of the rest, returns the cover lifted back to the whole graph
+    std::vector<size_t> CoverWithLp();
+
+    // sorted neighbour lists of the materialized edges, without duplicates
+    std::vector<std::vector<size_t>> Adjacency() const;
+
+    void Coloring(const std::vector<std::vector<size_t>>& adj);
+
+    // reads the row weights on first use of a weighted graph
+    void LoadWeights();
+
+    std::vector<double> ReadWeights();
+
+    inline double Weight(size_t node_id) const {
+        return node_id < weights_.size() ? weights_[node_id] : 1.0;
+    }
 
     size_t MostColor();
 
-    void LpSolver();
+    // Covers every component of adj the ExactVertexCover solvers handle and clears its
+    // lists, so only the remaining edges go to the LP.
+    std::vector<size_t> SolveExactComponents(std::vector<std::vector<size_t>>* adj);
+
+    // LP relaxation over the edges of adj, lp_ of nodes without one is 0
+    void LpSolver(const std::vector<std::vector<size_t>>& adj);
 
     std::vector<size_t> EliminateTriangles();
 
@@ -183,9 +461,40 @@ private:
 
     void DelTriangle(size_t u, size_t v, size_t w);
 
+    std::shared_ptr<const Oracle> BuildOracle(const SubsetQuery& query);
+
+    // Oracle::CumulativeWeights() of the row weights, empty on unweighted graphs
+    std::vector<double> SampleWeights(const Oracle& oracle);
+
+    // cumulative from Oracle::CumulativeWeights() samples by weight, uniformly if empty
+    size_t SampleVertexCover(size_t sample_number, const Oracle& oracle, const std::vector<double>& cumulative);
+
+    EdgeList Neighbours(size_t node_id);
+
+    EdgeList GenerateNeighbours(size_t node_id);
+
+    // null for nodes outside every conflict group
+    std::shared_ptr<GroupNeighbourOrder> GroupNeighbours(size_t node_id);
+
+    EdgeId VirtualEdgeId(size_t u, size_t v);
+
+    void ClearMemo();
+
+    // samples a node of the subgraph and answers whether it is in the vertex cover
+    bool ProbeSample(const Oracle& oracle, const std::vector<double>& cumulative);
+
     bool InVertexcover(size_t node_id, const Oracle& oracle);
 
     bool InMatching(size_t u, const Edge& edge, const Oracle& oracle);
+
+    // Weighted counterpart of the matching LCA, simulating Bar-Yehuda-Even over the edges
+    // in rank order: the dual of an edge is the smaller residual weight of its endpoints
+    // after the duals of their lower ranked edges, and a node is in the cover once its
+    // residual reaches 0. Unit weights give back the matching. Residual() counts the
+    // edges ranked below before, all of them if null.
+    double Residual(size_t u, const Edge* before, const Oracle& oracle);
+
+    double EdgeDual(size_t u, const Edge& edge, const Oracle& oracle);
 };
 
 
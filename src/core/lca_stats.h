@@ -0,0 +1,47 @@
+#ifndef DCR_CORE_LCA_STATS_H_
+#define DCR_CORE_LCA_STATS_H_
+
+#include <cstddef>
+#include <vector>
+
+// Counters of the LCA estimator, compiled out with -DDCR_DISABLE_STATS.
+#ifndef DCR_DISABLE_STATS
+#define DCR_STAT(expr) do { expr; } while (0)
+#else
+#define DCR_STAT(expr) do {} while (0)
+#endif
+
+namespace dcr {
+
+struct LcaStats {
+    size_t in_matching_calls_ = 0;
+    // lookups in the vertex cover and matching memos
+    size_t memo_hits_ = 0;
+    size_t memo_misses_ = 0;
+    size_t max_depth_ = 0;
+    // adjacency entries visited by the rank-merge loop of InMatching
+    size_t edges_scanned_ = 0;
+    size_t oracle_checks_ = 0;
+    // InMatching calls per sample, bucket b counts samples costing [2^(b-1), 2^b) calls
+    // and bucket 0 those answered without any call
+    std::vector<size_t> probe_histogram_;
+
+    void RecordSample(size_t cost) {
+        size_t bucket = 0;
+        while (cost != 0) {
+            bucket++;
+            cost >>= 1;
+        }
+        if (probe_histogram_.size() <= bucket) {
+            probe_histogram_.resize(bucket + 1, 0);
+        }
+        probe_histogram_[bucket]++;
+    }
+
+    void Clear() {
+        *this = LcaStats();
+    }
+};
+
+}  // dcr
+#endif  // DCR_CORE_LCA_STATS_H_
@@ -0,0 +1,61 @@
+#ifndef DCR_CORE_LRU_CACHE_H_
+#define DCR_CORE_LRU_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace dcr {
+
+// Bounded map evicting the least recently used entry once capacity is reached.
+template <typename K, typename V>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity): capacity_(capacity) {}
+
+    bool Get(const K& key, V* value) {
+        auto iter = index_.find(key);
+        if (iter == index_.end()) {
+            return false;
+        }
+        items_.splice(items_.begin(), items_, iter->second);
+        *value = iter->second->second;
+        return true;
+    }
+
+    void Put(const K& key, const V& value) {
+        auto iter = index_.find(key);
+        if (iter != index_.end()) {
+            iter->second->second = value;
+            items_.splice(items_.begin(), items_, iter->second);
+            return;
+        }
+        if (capacity_ == 0) {
+            return;
+        }
+        if (items_.size() >= capacity_) {
+            index_.erase(items_.back().first);
+            items_.pop_back();
+        }
+        items_.emplace_front(key, value);
+        index_[key] = items_.begin();
+    }
+
+    inline size_t Size() const {
+        return items_.size();
+    }
+
+    void Clear() {
+        items_.clear();
+        index_.clear();
+    }
+
+private:
+    size_t capacity_;
+    std::list<std::pair<K, V>> items_;
+    std::unordered_map<K, typename std::list<std::pair<K, V>>::iterator> index_;
+};
+
+}  // dcr
+#endif  // DCR_CORE_LRU_CACHE_H_
@@ -1,30 +1,83 @@
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 #include "core/oracle.h"
+#include "core/parallel.h"
 #include "core/table.h"
 
 namespace dcr {
 using std::vector;
 using std::string;
 
+Oracle::Oracle(Table& table, const SubsetQuery& query) {
+    CheckAttributes(table, query);
+    in_subgraph_ = table.FindMembership(query);
+    in_subgraph_.ToVector(&nodes_);
+}
 
-Oracle::Oracle(const Table& table, const IncDegreeQuery& q) {
-    if (!table.GetEnableSql()) {
-        TableIterator iter = table_.GetIterator();
+void Oracle::CheckAttributes(const Table& table, const SubsetQuery& query) {
+    const vector<string>& schema = table.GetSchemaAttributes();
+    for (const string& attr: query.GetAttributes()) {
+        if (std::find(schema.begin(), schema.end(), attr) == schema.end()) {
+            throw "Query attribute not in the table!";
+        }
+    }
+}
 
-        while (iter.HasNext()) {
-            Record r = iter.Next();
+vector<Oracle> Oracle::BuildBatch(Table& table, const vector<SubsetQuery>& queries) {
+    const vector<string>& projected = table.GetTableAttrbutes();
+    vector<Bitmap> in_subgraph(queries.size());
+    // queries on attributes outside the projection are left to FindMembership, scanned
+    // rows only carry the projected columns
+    vector<size_t> scanned;
+    vector<vector<int32_t>> columns;
+    for (size_t i = 0; i < queries.size(); i++) {
+        CheckAttributes(table, queries[i]);
+        bool in_projection = true;
+        for (const string& attr: queries[i].GetAttributes()) {
+            in_projection = in_projection && std::find(projected.begin(), projected.end(), attr) != projected.end();
+        }
+        if (in_projection) {
+            scanned.push_back(i);
+            columns.push_back(queries[i].ResolveColumns(projected));
+        } else {
+            in_subgraph[i] = table.FindMembership(queries[i]);
+        }
+    }
+    if (scanned.empty()) {
+        return vector<Oracle>(in_subgraph.begin(), in_subgraph.end());
+    }
 
-            if (q.SatisfyRange(r)) {
-                nodes_.insert(r.GetRowIdx());
+    // one set of bitmaps per partition, merged afterwards
+    vector<std::unique_ptr<TableIterator>> iters = table.GetPartitionedIterators();
+    vector<vector<Bitmap>> partial(iters.size(), vector<Bitmap>(scanned.size()));
+    ParallelFor(iters.size(), [&](size_t p) {
+        RowBatch batch;
+        while (iters[p]->NextBatch(&batch, RowBatch::kDefaultRows) != 0) {
+            for (size_t k = 0; k < scanned.size(); k++) {
+                const SubsetQuery& query = queries[scanned[k]];
+                for (size_t j = 0; j < batch.Size(); j++) {
+                    RecordView r = batch.GetRow(j);
+                    if (query.Satisfy(columns[k], [&](size_t col) { return r.GetField(col); })) {
+                        partial[p][k].Set(r.GetRowIndex());
+                    }
+                }
             }
         }
-    } else {
-        vector<size_t> ret = table_.Find(q.ToSqlString());
-        for (size_t idx: ret) {
-            nodes_.insert(idx);
+    });
+    for (vector<Bitmap>& bitmaps: partial) {
+        for (size_t k = 0; k < scanned.size(); k++) {
+            in_subgraph[scanned[k]].Or(bitmaps[k]);
         }
     }
+
+    vector<Oracle> oracles;
+    oracles.reserve(queries.size());
+    for (const Bitmap& bitmap: in_subgraph) {
+        oracles.emplace_back(bitmap);
+    }
+    return oracles;
 }
 
 }  // dcr
\ No newline at end of file
@@ -1,13 +1,12 @@
 #ifndef DCR_CORE_ORACLE_H_
 #define DCR_CORE_ORACLE_H_
+#include <algorithm>
 #include <cstdlib>
 #include <string>
 #include <vector>
 #include <utility>
-// only supported with g++ >= 3.3.1
-#include <ext/pb_ds/assoc_container.hpp>
-#include <ext/pb_ds/tree_policy.hpp>
 
+#include "core/bitmap.h"
 #include "core/table.h"
 #include "core/subset_query.h"
 
@@ -19,31 +18,63 @@ class SubsetQuery;
 class Oracle {
 
 public:
-    Oracle(const Table& table, const SubsetQuery& query) {
-        std::vector<size_t> ret = table.Find(query);
-        for (size_t node_idx: ret) {
-            nodes_.insert(node_idx);
-        }
+    // queries on attributes the table does not have throw
+    Oracle(Table& table, const SubsetQuery& query);
+
+    explicit Oracle(const Bitmap& in_subgraph): in_subgraph_(in_subgraph) {
+        in_subgraph_.ToVector(&nodes_);
     }
 
+    // Evaluates all queries in a single scan of the table, one membership bitmap per query.
+    // Queries on attributes outside the projection are answered by FindMembership instead,
+    // attributes the table does not have at all throw as for a single query.
+    static std::vector<Oracle> BuildBatch(Table& table, const std::vector<SubsetQuery>& queries);
+
     bool InSubgraph(size_t node_id) const {
-        return nodes_.find(node_id) != nodes_.end();
+        return in_subgraph_.Test(node_id);
     }
 
     size_t SampleNode() const {
-        return *nodes_.find_by_order(rand() % nodes_.size());
+        return nodes_[rand() % nodes_.size()];
+    }
+
+    // running totals of weights (indexed by node id) over the members, for SampleNode;
+    // members past the end of weights weigh 1, as in Graph
+    std::vector<double> CumulativeWeights(const std::vector<double>& weights) const {
+        std::vector<double> cumulative;
+        cumulative.reserve(nodes_.size());
+        double total = 0.0;
+        for (size_t node_id: nodes_) {
+            total += node_id < weights.size() ? weights[node_id] : 1.0;
+            cumulative.push_back(total);
+        }
+        return cumulative;
+    }
+
+    // a member drawn with probability proportional to its weight, the last running total
+    // must be positive
+    size_t SampleNode(const std::vector<double>& cumulative) const {
+        double target = cumulative.back() * (rand() / ((double)RAND_MAX + 1.0));
+        return nodes_[std::upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin()];
     }
 
     size_t NumberofNodesInSubgraph() const {
         return nodes_.size();
     }
 
+    const Bitmap& GetMembership() const {
+        return in_subgraph_;
+    }
+
 
 private:
-    __gnu_pbds::tree<size_t, 
-                    __gnu_pbds::null_type, std::less<size_t>,
-                    __gnu_pbds::rb_tree_tag,
-                    __gnu_pbds::tree_order_statistics_node_update> nodes_;
+    // throws on attributes missing from the schema, which backends would otherwise read
+    // as empty or fail on in their own way
+    static void CheckAttributes(const Table& table, const SubsetQuery& query);
+
+    Bitmap in_subgraph_;
+    // sorted members, sampled by position
+    std::vector<size_t> nodes_;
 };
 
 }  // dcr
@@ -0,0 +1,75 @@
+#ifndef DCR_CORE_PARALLEL_H_
+#define DCR_CORE_PARALLEL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dcr {
+
+// Runs fn(i) for every i in [0, n) on its own thread, the calling thread takes i = 0.
+// The first exception thrown by any fn is rethrown once all of them have finished.
+template <typename Fn>
+void ParallelFor(size_t n, const Fn& fn) {
+    std::vector<std::exception_ptr> errors(n);
+    auto run = [&](size_t i) {
+        try {
+            fn(i);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < n; i++) {
+        workers.emplace_back(run, i);
+    }
+    if (n > 0) {
+        run(0);
+    }
+    for (std::thread& worker: workers) {
+        worker.join();
+    }
+    for (std::exception_ptr& error: errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Reusable barrier for a fixed number of threads, e.g. the workers of one ParallelFor
+// running several rounds. A thread that throws instead of arriving blocks the others, so
+// the code between waits must not throw.
+class Barrier {
+public:
+    explicit Barrier(size_t count): count_(count) {}
+
+    Barrier(const Barrier&) = delete;
+
+    Barrier& operator=(const Barrier&) = delete;
+
+    // returns once all count threads have called it
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        size_t generation = generation_;
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            generation_++;
+            cv_.notify_all();
+        } else {
+            cv_.wait(lock, [&] { return generation != generation_; });
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t count_;
+    size_t waiting_ = 0;
+    size_t generation_ = 0;
+};
+
+}  // dcr
+#endif  // DCR_CORE_PARALLEL_H_
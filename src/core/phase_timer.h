@@ -0,0 +1,59 @@
+#ifndef DCR_CORE_PHASE_TIMER_H_
+#define DCR_CORE_PHASE_TIMER_H_
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dcr {
+
+// Wall time accumulated per named phase, in first-seen order.
+class PhaseTimes {
+public:
+    void Add(const std::string& phase, double seconds) {
+        for (auto& kv: phases_) {
+            if (kv.first == phase) {
+                kv.second += seconds;
+                return;
+            }
+        }
+        phases_.emplace_back(phase, seconds);
+    }
+
+    inline const std::vector<std::pair<std::string, double>>& Get() const {
+        return phases_;
+    }
+
+    void Clear() {
+        phases_.clear();
+    }
+
+private:
+    std::vector<std::pair<std::string, double>> phases_;
+};
+
+
+// Adds the lifetime of the scope to a phase.
+class ScopedPhase {
+public:
+    ScopedPhase(PhaseTimes* times, const char* phase): times_(times), phase_(phase),
+            start_(std::chrono::steady_clock::now()) {}
+
+    ScopedPhase(const ScopedPhase&) = delete;
+
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    ~ScopedPhase() {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+        times_->Add(phase_, elapsed.count());
+    }
+
+private:
+    PhaseTimes* times_;
+    const char* phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // dcr
+#endif  // DCR_CORE_PHASE_TIMER_H_
@@ -0,0 +1,33 @@
+#include "core/query_cache.h"
+
+namespace dcr {
+using std::shared_ptr;
+using std::string;
+
+shared_ptr<const SubsetQuery> QueryCache::GetQuery(const string& text) {
+    shared_ptr<const SubsetQuery> query;
+    if (!queries_.Get(text, &query)) {
+        query = std::make_shared<const SubsetQuery>(text);
+        queries_.Put(text, query);
+    }
+    return query;
+}
+
+shared_ptr<const Oracle> QueryCache::GetOracle(Table& table, const SubsetQuery& query) {
+    // the instance id tells tables of the same name apart and, unlike the address, is not
+    // reused by a table allocated after this one is gone; the version invalidates entries
+    // of changed tables
+    string key = table.GetTableName() + '\x1e' + std::to_string(table.GetInstanceId()) + '\x1e' +
+                 std::to_string(table.GetVersion()) + '\x1e' + query.NormalizedText();
+    shared_ptr<const Oracle> oracle;
+    if (oracles_.Get(key, &oracle)) {
+        hits_++;
+        return oracle;
+    }
+    misses_++;
+    oracle = std::make_shared<const Oracle>(table, query);
+    oracles_.Put(key, oracle);
+    return oracle;
+}
+
+}  // dcr
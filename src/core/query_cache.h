@@ -0,0 +1,46 @@
+#ifndef DCR_CORE_QUERY_CACHE_H_
+#define DCR_CORE_QUERY_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "core/lru_cache.h"
+#include "core/oracle.h"
+#include "core/subset_query.h"
+#include "core/table.h"
+
+namespace dcr {
+
+// Caches parsed queries by their text and oracles by normalized query text and table
+// version, so a re-issued query skips parsing and the table scan.
+class QueryCache {
+public:
+    explicit QueryCache(size_t capacity = 1024): queries_(capacity), oracles_(capacity) {}
+
+    std::shared_ptr<const SubsetQuery> GetQuery(const std::string& text);
+
+    // oracle of query on table, built on a miss
+    std::shared_ptr<const Oracle> GetOracle(Table& table, const SubsetQuery& query);
+
+    inline size_t GetHits() const {
+        return hits_;
+    }
+
+    inline size_t GetMisses() const {
+        return misses_;
+    }
+
+    void Clear() {
+        queries_.Clear();
+        oracles_.Clear();
+    }
+
+private:
+    LruCache<std::string, std::shared_ptr<const SubsetQuery>> queries_;
+    LruCache<std::string, std::shared_ptr<const Oracle>> oracles_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+}  // dcr
+#endif  // DCR_CORE_QUERY_CACHE_H_
@@ -8,60 +8,76 @@ using std::string;
 using std::vector;
 using std::stack;
 
-SubsetQuery::Node* SubsetQuery::ConstructQueryTree(const string& query) {
-    stack<SubsetQuery::Node*> st1;
+// operator stack entries: 0 and, 1 or, 2 open parenthesis
+static inline int Precedence(int c) {
+    return c == 0 ? 2 : (c == 1 ? 1 : 0);
+}
+
+// first " and ", " or ", "(" or ")" at or after pivot outside quoted literals, npos if none
+static size_t NextToken(const string& query, size_t pivot) {
+    char quote = 0;
+    for (size_t i = pivot; i < query.size(); i++) {
+        char c = query[i];
+        if (quote != 0) {
+            // a doubled quote closes and reopens
+            if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+        } else if (c == '(' || c == ')' || query.compare(i, 5, " and ") == 0 || query.compare(i, 4, " or ") == 0) {
+            return i;
+        }
+    }
+    return string::npos;
+}
+
+int32_t SubsetQuery::ConstructQueryTree() {
+    const string& query = query_;
+    stack<int32_t> st1;
     stack<int> st2;
+    nodes_.reserve(query.size() / 4 + 1);
+    vals_.reserve(query.size());
 
-    int pivot = 0;
-    int pos = 0;
+    // pops an operator and its two operands into a new node
+    auto reduce = [&](size_t pos) {
+        int c = st2.top();
+        st2.pop();
+        if (st1.size() < 2) {
+            throw InvalidExpressionException(query.substr(0, pos));
+        }
+        int32_t right = st1.top();
+        st1.pop();
+        int32_t left = st1.top();
+        st1.pop();
+        nodes_.emplace_back(c, left, right);
+        st1.push(nodes_.size() - 1);
+    };
+
+    size_t pivot = 0;
+    size_t pos = 0;
     while (true) {
-        unsigned int pos1 = query.find(" and ", pivot);
-        unsigned int pos2 = query.find(" or ", pivot);
-        unsigned int pos3 = query.find("(", pivot);
-        unsigned int pos4 = query.find(")", pivot);
-        pos = std::min(pos1, std::min(pos2, std::min(pos3, pos4)));
-        
-        if (pos >= query.size()) {
+        pos = NextToken(query, pivot);
+        if (pos > query.size()) {
             pos = query.size();
-            SubsetQuery::Tuple t = Parse(query.substr(pivot, pos-pivot));
+        }
 
-            SubsetQuery::Node* node = new SubsetQuery::Node(t.attr_name_, t.val_, t.op_);
-            st1.push(node);
-            nodes_.push_back(node);
+        if (query.find_first_not_of(' ', pivot) < pos) {
+            nodes_.emplace_back(Parse(pivot, pos));
+            st1.push(nodes_.size() - 1);
+        }
+        if (pos == query.size()) {
             break;
         }
 
-        switch (query[pos]) { 
+        switch (query[pos]) {
             case ' ': {
-                if (st2.size() < 1) {
-                    throw InvalidExpressionException(query.substr(0, pos));
-                }
-                int c = st2.top();
-                if (c == 0 || c == 1) {
-                    st2.pop();
-                    if (st1.size() < 2) {
-                        throw InvalidExpressionException(query.substr(0, pos));
-                    }
-                    SubsetQuery::Node* right = st1.top();
-                    st1.pop();
-                    SubsetQuery::Node* left = st1.top();
-                    st1.pop();
-
-                    SubsetQuery::Node* node = new SubsetQuery::Node(c);
-                    node->left_ = left;
-                    node->right_ = right;
-                    st1.push(node);
-                    nodes_.push_back(node);
-                }
-
-                pos = pos + 1;
-                if (query[pos] == 'a') {
-                    st2.push(0);
-                    pivot = pos + 4;
-                } else {
-                    st2.push(1);
-                    pivot = pos + 3;
+                int c = query[pos + 1] == 'a' ? 0 : 1;
+                while (!st2.empty() && st2.top() != 2 && Precedence(st2.top()) >= Precedence(c)) {
+                    reduce(pos);
                 }
+                st2.push(c);
+                pivot = pos + (c == 0 ? 5 : 4);
                 break;
             }
             case '(': {
@@ -70,31 +86,11 @@ SubsetQuery::Node* SubsetQuery::ConstructQueryTree(const string& query) {
                 break;
             }
             case ')': {
-                if (st2.size() < 1) {
-                    throw InvalidExpressionException(query.substr(0, pos));
+                while (!st2.empty() && st2.top() != 2) {
+                    reduce(pos);
                 }
-                while (true) {
-                    int c = st2.top();
-                    if (c == 2) {
-                        break;
-                    }
-                    st2.pop();
-                    if (st1.size() < 2) {
-                        throw InvalidExpressionException(query.substr(0, pos));
-                    }
-                    SubsetQuery::Node* right = st1.top();
-                    st1.pop();
-                    SubsetQuery::Node* left = st1.top();
-                    st1.pop();
-
-                    SubsetQuery::Node* node = new SubsetQuery::Node(c);
-                    node->left_ = left;
-                    node->right_ = right;
-                    st1.push(node);
-                    nodes_.push_back(node);
-                    if (st2.size() < 1) {
-                        throw InvalidExpressionException(query.substr(0, pos));
-                    }
+                if (st2.empty()) {
+                    throw InvalidExpressionException(query.substr(0, pos));
                 }
                 st2.pop();
                 pivot = pos + 1;
@@ -103,102 +99,246 @@ SubsetQuery::Node* SubsetQuery::ConstructQueryTree(const string& query) {
         }
     }
 
-    if (st2.size() >= 1 || (st2.size() > 0 && st2.top() != 0 && st2.top() != 1)) {
-        throw InvalidExpressionException(query.substr(0, pos));
-    } else if (st2.size() == 1) {
-        int c = st2.top();
-        st2.pop();
-
-        if (st1.size() < 2) {
+    while (!st2.empty()) {
+        if (st2.top() == 2) {
             throw InvalidExpressionException(query.substr(0, pos));
         }
-        SubsetQuery::Node* right = st1.top();
-        st1.pop();
-        SubsetQuery::Node* left = st1.top();
-        st1.pop();
-
-        SubsetQuery::Node* node = new SubsetQuery::Node(c);
-        node->left_ = left;
-        node->right_ = right;
-        st1.push(node);
-        nodes_.push_back(node);
+        reduce(pos);
     }
-
-    SubsetQuery::Node* root = st1.top();
-    st1.pop();
-    return root;
+    if (st1.size() != 1) {
+        throw InvalidExpressionException(query.substr(0, pos));
+    }
+    return st1.top();
 }
 
 
-SubsetQuery::Tuple SubsetQuery::Parse(const string& s) {
+SubsetQuery::Tuple SubsetQuery::Parse(size_t begin, size_t end) {
+    const string& s = query_;
     SubsetQuery::Tuple t;
-    int start = 0;
-    int end = s.size();
-    int tmp_pivot = -1;
-    for (int i = start; i < end; ++i) {
+    size_t op_begin = end;
+    size_t tmp_pivot = end;
+    for (size_t i = begin; i < end && t.op_ == -1; ++i) {
         switch (s[i]) {
             case '>': {
-                t.attr_name_ = TrimCopy(s.substr(start, i - start));
-                if (s[i+1] == '=') {
-                    t.op_ = 1;
-                    tmp_pivot = i+2;
-                } else {
-                    t.op_ = 0;
-                    tmp_pivot = i+1;
-                }
+                t.op_ = i + 1 < end && s[i+1] == '=' ? 1 : 0;
                 break;
             }
             case '=': {
-                t.attr_name_ = TrimCopy(s.substr(start, i - start));
                 t.op_ = 2;
-                tmp_pivot = i+1;
                 break;
             }
             case '!': {
-                if (s[i+1] == '=') {
-                    t.attr_name_ = TrimCopy(s.substr(start, i - start));
+                if (i + 1 < end && s[i+1] == '=') {
                     t.op_ = 3;
-                    tmp_pivot = i+2;
                 }
                 break;
             }
             case '<': {
-                if (s[i+1] == '=') {
-                    t.attr_name_ = TrimCopy(s.substr(start, i - start));
-                    t.op_ = 4;
-                    tmp_pivot = i+2;
-                } else {
-                    t.attr_name_ = TrimCopy(s.substr(start, i - start));
-                    t.op_ = 5;
-                    tmp_pivot = i+1;
-                }
+                t.op_ = i + 1 < end && s[i+1] == '=' ? 4 : 5;
                 break;
             }
         }
-        if (tmp_pivot != -1) {
-            break;
+        if (t.op_ != -1) {
+            op_begin = i;
+            tmp_pivot = (t.op_ == 0 || t.op_ == 2 || t.op_ == 5) ? i + 1 : i + 2;
         }
     }
+    if (t.op_ == -1) {
+        throw InvalidExpressionException(s.substr(begin, end - begin));
+    }
 
-    t.val_ = TrimCopy(s.substr(tmp_pivot, end - tmp_pivot));
+    // trimmed slices of the query text
+    auto trim = [&](size_t from, size_t to, uint32_t* out_begin, uint32_t* out_len) {
+        while (from < to && s[from] == ' ') {
+            from++;
+        }
+        while (to > from && s[to - 1] == ' ') {
+            to--;
+        }
+        *out_begin = from;
+        *out_len = to - from;
+    };
+    trim(begin, op_begin, &t.attr_begin_, &t.attr_len_);
+    uint32_t val_begin, val_len;
+    trim(tmp_pivot, end, &val_begin, &val_len);
+
+    t.val_begin_ = vals_.size();
+    char quote = val_len > 0 ? s[val_begin] : 0;
+    if (quote == '\'' || quote == '"') {
+        if (val_len < 2 || s[val_begin + val_len - 1] != quote) {
+            throw InvalidExpressionException(s.substr(begin, end - begin));
+        }
+        for (size_t i = val_begin + 1; i + 1 < val_begin + val_len; i++) {
+            vals_ += s[i];
+            if (s[i] == quote) {
+                // the closing quote ends the literal, so this one is doubled
+                if (s[i + 1] != quote || i + 2 >= val_begin + val_len) {
+                    throw InvalidExpressionException(s.substr(begin, end - begin));
+                }
+                i++;
+            }
+        }
+    } else {
+        vals_.append(s, val_begin, val_len);
+    }
+    t.val_len_ = vals_.size() - t.val_begin_;
     return t;
 }
 
 
-bool SubsetQuery::SatisfyRange(const Record& r) const {
-    if (root_ == nullptr) {
-        return true;    
+static const char* kOperators[] = {">", ">=", "=", "!=", "<=", "<"};
+
+string SubsetQuery::Template() const {
+    if (root_ == -1) {
+        return "1 = 1";
+    }
+    string out;
+    AppendTemplate(root_, &out);
+    return out;
+}
+
+vector<std::string_view> SubsetQuery::Literals() const {
+    vector<std::string_view> out;
+    if (root_ != -1) {
+        AppendLiterals(root_, &out);
+    }
+    return out;
+}
+
+string SubsetQuery::NormalizedText() const {
+    string out = Template();
+    for (std::string_view literal: Literals()) {
+        out += '\x1f';
+        out.append(literal.data(), literal.size());
+    }
+    return out;
+}
+
+void SubsetQuery::AppendTemplate(int32_t node_idx, string* out) const {
+    const Node& node = nodes_[node_idx];
+    if (node.concate_ == -1) {
+        std::string_view attr = Attr(node);
+        out->append(attr.data(), attr.size());
+        *out += ' ';
+        *out += kOperators[node.op_];
+        *out += " ?";
+        return;
+    }
+    *out += '(';
+    AppendTemplate(node.left_, out);
+    *out += node.concate_ == 0 ? " and " : " or ";
+    AppendTemplate(node.right_, out);
+    *out += ')';
+}
+
+void SubsetQuery::AppendLiterals(int32_t node_idx, vector<std::string_view>* out) const {
+    const Node& node = nodes_[node_idx];
+    if (node.concate_ == -1) {
+        out->push_back(Val(node));
+        return;
+    }
+    AppendLiterals(node.left_, out);
+    AppendLiterals(node.right_, out);
+}
+
+
+vector<string> SubsetQuery::GetAttributes() const {
+    vector<string> attrs;
+    for (const Node& node: nodes_) {
+        if (node.concate_ == -1 && std::find(attrs.begin(), attrs.end(), Attr(node)) == attrs.end()) {
+            attrs.push_back(string(Attr(node)));
+        }
+    }
+    return attrs;
+}
+
+vector<int32_t> SubsetQuery::ResolveColumns(const vector<string>& attrs) const {
+    vector<int32_t> columns(nodes_.size(), -1);
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        if (nodes_[i].concate_ != -1) {
+            continue;
+        }
+        auto iter = std::find(attrs.begin(), attrs.end(), Attr(nodes_[i]));
+        if (iter != attrs.end()) {
+            columns[i] = iter - attrs.begin();
+        }
+    }
+    return columns;
+}
+
+
+bool SubsetQuery::Satisfy(const Record& r) const {
+    if (root_ == -1) {
+        return true;
     } else {
-        return root_->Satisfy(r);
+        return Satisfy(root_, r);
+    }
+}
+
+
+bool SubsetQuery::Satisfy(int32_t node_idx, const Record& r) const {
+    const Node& node = nodes_[node_idx];
+    if (node.concate_ == 0) {
+        return Satisfy(node.left_, r) && Satisfy(node.right_, r);
+    } else if (node.concate_ == 1) {
+        return Satisfy(node.left_, r) || Satisfy(node.right_, r);
+    }
+
+    std::string attr_val = r.GetField(std::string(Attr(node)));
+    return Compare(node.op_, attr_val, Val(node));
+}
+
+
+SubsetQuery::Match SubsetQuery::ClassifyRange(int op, std::string_view low, std::string_view high,
+        std::string_view val) {
+    bool all = false, none = false;
+    switch (op) {
+        case 0:  // >
+            all = low > val;
+            none = high <= val;
+            break;
+        case 1:  // >=
+            all = low >= val;
+            none = high < val;
+            break;
+        case 2:  // =
+            all = low == val && high == val;
+            none = val < low || val > high;
+            break;
+        case 3:  // !=
+            all = val < low || val > high;
+            none = low == val && high == val;
+            break;
+        case 4:  // <=
+            all = high <= val;
+            none = low > val;
+            break;
+        case 5:  // <
+            all = high < val;
+            none = low >= val;
+            break;
     }
+    return all ? Match::kAll : (none ? Match::kNone : Match::kSome);
 }
 
 
-SubsetQuery::~SubsetQuery() {
-    for (SubsetQuery::Node* node : nodes_) {
-        delete node;
+bool SubsetQuery::Compare(int op, std::string_view attr_val, std::string_view val) {
+    switch (op) {
+        case 0:  // >
+            return attr_val > val;
+        case 1:  // >=
+            return attr_val >= val;
+        case 2:  // =
+            return attr_val == val;
+        case 3:  // !=
+            return attr_val != val;
+        case 4:  // <=
+            return attr_val <= val;
+        case 5:  // <
+            return attr_val < val;
     }
+    return true;
 }
 
 
-}  // dcr
\ No newline at end of file
+}  // dcr
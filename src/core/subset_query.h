@@ -1,7 +1,9 @@
 #ifndef DCR_CORE_SUBSET_QUERY_H_
 #define DCR_CORE_SUBSET_QUERY_H_
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <exception>
 #include "core/table.h"
@@ -9,26 +11,95 @@
 
 namespace dcr {
 
+class InvalidExpressionException: public std::exception {
+public:
+    explicit InvalidExpressionException(const std::string& expr): msg_("Invalid expression: " + expr) {}
+
+    const char* what() const noexcept {
+        return msg_.c_str();
+    }
+
+private:
+    std::string msg_;
+};
+
+
 class SubsetQuery {
 public:
+    // how many rows of a block may satisfy the query, judged from column bounds only
+    enum class Match {kNone, kSome, kAll};
+
+    // comparison of a leaf, in the encoding of the parse nodes
+    enum Op {kGt = 0, kGe, kEq, kNe, kLe, kLt};
+
     /*
-        query language satisfy at least following grammar: 
+        query language satisfy at least following grammar:
             S = (A and | or S) | A | A and S | A or S
             A = attr >|>=|=|!=|<=|< B,
-            B = [all letters except >|>=|=|!=|<=|<|and|or ]
+            B = [all letters except >|>=|=|!=|<=|<|and|or ] | 'text' | "text"
             attr = [all letters except >|>=|=|!=|<=|< ]
+        "and" binds tighter than "or", as in the SQL the query is handed to. Quoted
+        literals may contain anything, a doubled quote stands for itself, and are
+        compared without their quotes.
     */
 
-	virtual bool Satisfy(Record& r);
+	bool Satisfy(const Record& r) const;
+
+	bool Satisfy(const RecordView& r) const {
+		return root_ == -1 || Satisfy(root_, r);
+	}
+
+	std::string ToString() const {
+		return query_;
+	}
+
+	// Canonical form with every literal replaced by '?': single spaces, canonical
+	// operators and one pair of parentheses per and/or, e.g. "(region = ? and year >= ?)".
+	// Queries differing only in whitespace, redundant parentheses or constants share it.
+	std::string Template() const;
+
+	// literals in the order of the '?' placeholders of Template()
+	std::vector<std::string_view> Literals() const;
+
+	// Template() plus the literals, equal exactly for equivalent query texts
+	std::string NormalizedText() const;
+
+	// distinct attributes the query compares, in order of appearance
+	std::vector<std::string> GetAttributes() const;
+
+	// Column position of each parse node's attribute in attrs (-1 for and/or nodes and
+	// unknown attributes), resolved once per scan instead of per row.
+	std::vector<int32_t> ResolveColumns(const std::vector<std::string>& attrs) const;
+
+	// Satisfy() on a row given by value_at(column), columns from ResolveColumns().
+	template <typename ValueAt>
+	bool Satisfy(const std::vector<int32_t>& columns, const ValueAt& value_at) const {
+		return root_ == -1 || Satisfy(root_, columns, value_at);
+	}
+
+	// Folds the parse tree bottom up, leaf(attr, op, val) on comparisons and
+	// combine(is_and, left, right) on and/or nodes. The query must not be empty.
+	template <typename T, typename Leaf, typename Combine>
+	T Fold(const Leaf& leaf, const Combine& combine) const {
+		return Fold<T>(root_, leaf, combine);
+	}
+
+	inline bool Empty() const {
+		return root_ == -1;
+	}
 
-	virtual std::string ToString();
+	// Match of a block whose values of column c all lie in [min_at(c), max_at(c)].
+	template <typename MinAt, typename MaxAt>
+	Match Classify(const std::vector<int32_t>& columns, const MinAt& min_at, const MaxAt& max_at) const {
+		return root_ == -1 ? Match::kAll : Classify(root_, columns, min_at, max_at);
+	}
 
 	SubsetQuery(const std::string& str) {
 		query_ = str;
-		if (query.size() > 0) {
-			root_ = ConstructQueryTree(query_);
+		if (query_.size() > 0) {
+			root_ = ConstructQueryTree();
 		} else {
-			root_ = nullptr;
+			root_ = -1;
 			query_ = "1 = 1";
 		}
 	}
@@ -37,108 +108,121 @@ private:
 
     class Tuple {
     public:
-        bool operator==(const Tuple& other) const {
-            return this == &other;
-        }
-
         Tuple() = default;
 
-        std::string attr_name_;
-        std::string val_;
-        int op_;
+        uint32_t attr_begin_ = 0;
+        uint32_t attr_len_ = 0;
+        uint32_t val_begin_ = 0;
+        uint32_t val_len_ = 0;
+        int op_ = -1;
     };
 
 
+    // Parse tree nodes live in nodes_ and refer to their children by index, attributes are
+    // slices of query_ and unquoted values slices of vals_, so a parsed query owns exactly
+    // three allocations and can be copied freely.
     class Node {
     public:
         Node() = default;
 
-        bool operator==(const Node& other) const {
-            return this == &other;
-        }
+        Node(const Tuple& t): attr_begin_(t.attr_begin_), attr_len_(t.attr_len_), val_begin_(t.val_begin_),
+                val_len_(t.val_len_), left_(-1), right_(-1), op_(t.op_), concate_(-1) {}
 
-        Node(std::string& attr, std::string& val, int op): attr_(attr), val_(val), op_(op) {
-            concate_ = -1;
-            left_ = nullptr;
-            right_ = nullptr;
-        }
+        Node(int concate, int32_t left, int32_t right): attr_begin_(0), attr_len_(0), val_begin_(0), val_len_(0),
+                left_(left), right_(right), op_(-1), concate_(concate) {}
 
-        explicit Node(int concate) {
-            concate_ = concate;
-            attr_ = "";
-            val_ = "";
-            op_ = -1;
-            left_ = nullptr;
-            right_ = nullptr;
-        }
+        uint32_t attr_begin_;
+        uint32_t attr_len_;
+        uint32_t val_begin_;
+        uint32_t val_len_;
+        int32_t left_;
+        int32_t right_;
+        int8_t op_;
+        int8_t concate_;
+    };
 
-        bool Satisfy(const Record& r) const {
-            bool ret = true;
-            if (concate_ == -1) {
-                std::string attr_val = r.GetField(attr_);
-                switch (op_) {
-                    case 0: {  // >
-                        if (attr_val <= val_) {
-                            ret = false;
-                        }
-                        break;
-                    }
-                    case 1: {  // >= 
-                        if (attr_val < val_) {
-                            ret = false;
-                        }
-                        break;
-                    }
-                    case 2: {  // = 
-                        if (attr_val != val_) {
-                            ret = false;
-                        }
-                        break;
-                    }
-                    case 3: { // !=
-                        if (attr_val == val_) {
-                            ret = false;
-                        }
-                        break;
-                    }
-                    case 4: { // <= 
-                        if (attr_val > val_) {
-                            ret = false;
-                        }
-                        break;
-                    }
-                    case 5: { // <
-                        if (attr_val >= val_) {
-                            ret = false;
-                        }
-                        break;
-                    }
-                }
-            } else if (concate_ == 0) {
-                ret = left_->Satisfy(r) && right_->Satisfy(r);
-            } else if (concate_ == 1) {
-                ret = left_->Satisfy(r) || right_->Satisfy(r);
-            }
+    inline std::string_view Attr(const Node& node) const {
+        return std::string_view(query_).substr(node.attr_begin_, node.attr_len_);
+    }
 
-            return ret;
+    inline std::string_view Val(const Node& node) const {
+        return std::string_view(vals_).substr(node.val_begin_, node.val_len_);
+    }
+
+    bool Satisfy(int32_t node_idx, const Record& r) const;
+
+    bool Satisfy(int32_t node_idx, const RecordView& r) const {
+        const Node& node = nodes_[node_idx];
+        if (node.concate_ == 0) {
+            return Satisfy(node.left_, r) && Satisfy(node.right_, r);
+        } else if (node.concate_ == 1) {
+            return Satisfy(node.left_, r) || Satisfy(node.right_, r);
+        }
+        return Compare(node.op_, r.GetField(Attr(node)), Val(node));
+    }
+
+    template <typename ValueAt>
+    bool Satisfy(int32_t node_idx, const std::vector<int32_t>& columns, const ValueAt& value_at) const {
+        const Node& node = nodes_[node_idx];
+        if (node.concate_ == 0) {
+            return Satisfy(node.left_, columns, value_at) && Satisfy(node.right_, columns, value_at);
+        } else if (node.concate_ == 1) {
+            return Satisfy(node.left_, columns, value_at) || Satisfy(node.right_, columns, value_at);
+        }
+        std::string_view attr_val = columns[node_idx] == -1 ? std::string_view() :
+                std::string_view(value_at(columns[node_idx]));
+        return Compare(node.op_, attr_val, Val(node));
+    }
+
+    static bool Compare(int op, std::string_view attr_val, std::string_view val);
+
+    template <typename T, typename Leaf, typename Combine>
+    T Fold(int32_t node_idx, const Leaf& leaf, const Combine& combine) const {
+        const Node& node = nodes_[node_idx];
+        if (node.concate_ == -1) {
+            return leaf(Attr(node), static_cast<Op>(node.op_), Val(node));
+        }
+        return combine(node.concate_ == 0, Fold<T>(node.left_, leaf, combine), Fold<T>(node.right_, leaf, combine));
+    }
+
+    template <typename MinAt, typename MaxAt>
+    Match Classify(int32_t node_idx, const std::vector<int32_t>& columns, const MinAt& min_at,
+            const MaxAt& max_at) const {
+        const Node& node = nodes_[node_idx];
+        if (node.concate_ == -1) {
+            if (columns[node_idx] == -1) {
+                // unknown attributes read as empty on every row
+                return Compare(node.op_, std::string_view(), Val(node)) ? Match::kAll : Match::kNone;
+            }
+            return ClassifyRange(node.op_, min_at(columns[node_idx]), max_at(columns[node_idx]), Val(node));
+        }
+        Match left = Classify(node.left_, columns, min_at, max_at);
+        if (node.concate_ == 0 ? left == Match::kNone : left == Match::kAll) {
+            return left;
+        }
+        Match right = Classify(node.right_, columns, min_at, max_at);
+        if (node.concate_ == 0) {
+            return left == Match::kAll ? right : (right == Match::kNone ? right : Match::kSome);
         }
+        return left == Match::kNone ? right : (right == Match::kAll ? right : Match::kSome);
+    }
 
-        std::string attr_;
-        std::string val_;
-        int op_;
-        int concate_;
+    static Match ClassifyRange(int op, std::string_view low, std::string_view high, std::string_view val);
 
-        Node* left_;
-        Node* right_;
-    };
+    void AppendTemplate(int32_t node_idx, std::string* out) const;
+
+    void AppendLiterals(int32_t node_idx, std::vector<std::string_view>* out) const;
 
-    Node* ConstructQueryTree(const std::string& query);
+    int32_t ConstructQueryTree();
 
-    Tuple Parse(const std::string& s);
+    // appends the value to vals_
+    Tuple Parse(size_t begin, size_t end);
 
-    Node* root_;
-    std::vector<Node*> nodes_;
+    int32_t root_;
+    std::vector<Node> nodes_;
     std::string query_;
+    std::string vals_;
 };
 
-} // dcr 
\ No newline at end of file
+} // dcr
+#endif  // DCR_CORE_SUBSET_QUERY_H_
@@ -4,13 +4,18 @@
 #include <unordered_map>
 #include <string>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <sstream>
+#include <string_view>
 #include <vector>
-#include "core/subset_query.h"
+#include "core/bitmap.h"
 
 namespace dcr {
 
 class SubsetQuery;
+class RecordView;
 
 
 class Record {
@@ -25,7 +30,8 @@ public:
     }
 
     inline std::string GetField(std::string attr) const {
-        return content_[attr];
+        auto iter = content_.find(attr);
+        return iter == content_.end() ? std::string() : iter->second;
     }
 
     std::string ToString() {
@@ -36,7 +42,7 @@ public:
         return ss.str();
     }
 
-    inline size_t GetRowIndex() {
+    inline size_t GetRowIndex() const {
     	return row_idx_;
     }
 
@@ -44,17 +50,77 @@ public:
 
     explicit Record(size_t row_idx, const std::unordered_map<std::string, std::string>& content): row_idx_(row_idx), content_(content) {}
 
+    // fields of attrs written to fields, the view is valid while this record and attrs live
+    RecordView View(const std::vector<std::string>& attrs, std::vector<std::string_view>* fields) const;
+
 private:
-	std::unordered_map<std::string, std::string> content_;
 	size_t row_idx_;
+	std::unordered_map<std::string, std::string> content_;
 };
 
 
+// Non-owning row: field i is the value of attrs[i], pointing into table columns, a
+// statement row or a Record. Valid until that storage changes, so scans reuse one
+// buffer of views instead of allocating every cell.
+class RecordView {
+public:
+    RecordView() = default;
+
+    RecordView(size_t row_idx, const std::string_view* fields, const std::vector<std::string>* attrs):
+            fields_(fields), attrs_(attrs), row_idx_(row_idx) {}
+
+    inline std::string_view GetField(size_t col) const {
+        return fields_[col];
+    }
+
+    // empty for attributes not in the row, like Record::GetField
+    inline std::string_view GetField(std::string_view attr) const {
+        for (size_t i = 0; i < attrs_->size(); i++) {
+            if ((*attrs_)[i] == attr) {
+                return fields_[i];
+            }
+        }
+        return std::string_view();
+    }
+
+    inline size_t GetRowIndex() const {
+        return row_idx_;
+    }
+
+    inline const std::vector<std::string>& GetAttributes() const {
+        return *attrs_;
+    }
+
+    Record ToRecord() const {
+        std::unordered_map<std::string, std::string> content;
+        for (size_t i = 0; i < attrs_->size(); i++) {
+            content[(*attrs_)[i]] = std::string(fields_[i]);
+        }
+        return Record(row_idx_, content);
+    }
+
+private:
+    const std::string_view* fields_ = nullptr;
+    const std::vector<std::string>* attrs_ = nullptr;
+    size_t row_idx_ = 0;
+};
+
+
+inline RecordView Record::View(const std::vector<std::string>& attrs, std::vector<std::string_view>* fields) const {
+    fields->clear();
+    for (const std::string& attr: attrs) {
+        auto iter = content_.find(attr);
+        fields->push_back(iter == content_.end() ? std::string_view() : std::string_view(iter->second));
+    }
+    return RecordView(row_idx_, fields->data(), &attrs);
+}
+
+
 class FunctionalDependency {
 public:
     bool IsConflict(const Record& a, const Record& b) const {
-        vector<string> a_attr_vals = a.GetMultiFields(fd_.first);
-        vector<string> b_attr_vals = b.GetMultiFields(fd_.first);
+        std::vector<std::string> a_attr_vals = a.GetMultiFields(fd_.first);
+        std::vector<std::string> b_attr_vals = b.GetMultiFields(fd_.first);
         if (a_attr_vals == b_attr_vals) {
             a_attr_vals.clear();
             b_attr_vals.clear();
@@ -67,6 +133,29 @@ public:
         return false;
     }
 
+    bool IsConflict(const RecordView& a, const RecordView& b) const {
+        for (const std::string& attr: fd_.first) {
+            if (a.GetField(attr) != b.GetField(attr)) {
+                return false;
+            }
+        }
+        for (const std::string& attr: fd_.second) {
+            if (a.GetField(attr) != b.GetField(attr)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // positions of the LHS / RHS attributes in attrs, for column access on RecordViews
+    inline std::vector<size_t> GetLeftHandColumns(const std::vector<std::string>& attrs) const {
+        return Columns(fd_.first, attrs);
+    }
+
+    inline std::vector<size_t> GetRightHandColumns(const std::vector<std::string>& attrs) const {
+        return Columns(fd_.second, attrs);
+    }
+
     inline std::vector<std::string> GetLeftHandAttrs() const {
         return fd_.first;
     }
@@ -82,45 +171,311 @@ public:
 
     FunctionalDependency() = default;
 
+    // parses "A, B -> C", attributes on each side are separated by commas
+    static FunctionalDependency FromString(const std::string& str) {
+        size_t arrow = str.find("->");
+        if (arrow == std::string::npos) {
+            throw "Invalid functional dependency!";
+        }
+        std::vector<std::string> sides[2];
+        std::string parts[2] = {str.substr(0, arrow), str.substr(arrow + 2)};
+        for (int i = 0; i < 2; i++) {
+            std::stringstream ss(parts[i]);
+            std::string attr;
+            while (std::getline(ss, attr, ',')) {
+                size_t begin = attr.find_first_not_of(" \t");
+                size_t end = attr.find_last_not_of(" \t\r\n");
+                if (begin != std::string::npos) {
+                    sides[i].push_back(attr.substr(begin, end - begin + 1));
+                }
+            }
+            if (sides[i].empty()) {
+                throw "Invalid functional dependency!";
+            }
+        }
+        return FunctionalDependency(sides[0], sides[1]);
+    }
+
 private:
 
+    static std::vector<size_t> Columns(const std::vector<std::string>& fd_attrs,
+            const std::vector<std::string>& attrs) {
+        std::vector<size_t> cols;
+        for (const std::string& attr: fd_attrs) {
+            auto iter = std::find(attrs.begin(), attrs.end(), attr);
+            if (iter == attrs.end()) {
+                throw "Unknown attribute in functional dependency!";
+            }
+            cols.push_back(iter - attrs.begin());
+        }
+        return cols;
+    }
+
     std::pair<std::vector<std::string>, std::vector<std::string>> fd_;
 };
 
 
+// Up to a few thousand rows of a scan, row-major views. Values either point into
+// storage that outlives the batch (AddField) or are copied into chunks owned by the batch
+// (CopyField). All buffers are kept across Clear() so a scan allocates only while its
+// batches still grow.
+class RowBatch {
+public:
+    static constexpr size_t kDefaultRows = 4096;
+
+    RowBatch() = default;
+
+    RowBatch(const RowBatch&) = delete;
+    RowBatch& operator=(const RowBatch&) = delete;
+
+    void Clear(const std::vector<std::string>* attrs) {
+        attrs_ = attrs;
+        row_idx_.clear();
+        fields_.clear();
+        for (size_t i = 0; i <= chunk_ && i < chunks_.size(); i++) {
+            chunks_[i].size_ = 0;
+        }
+        chunk_ = 0;
+    }
+
+    inline void AddRow(size_t row_idx) {
+        row_idx_.push_back(row_idx);
+    }
+
+    inline void AddField(std::string_view val) {
+        fields_.push_back(val);
+    }
+
+    void CopyField(const char* data, size_t len) {
+        // chunks are never reallocated while they hold values, earlier views stay valid
+        while (chunk_ < chunks_.size() && chunks_[chunk_].capacity_ - chunks_[chunk_].size_ < len &&
+                chunks_[chunk_].size_ != 0) {
+            chunk_++;
+        }
+        if (chunk_ == chunks_.size()) {
+            chunks_.emplace_back();
+        }
+        Chunk& chunk = chunks_[chunk_];
+        if (chunk.capacity_ < len) {
+            chunk.capacity_ = std::max(kChunkBytes, len);
+            chunk.data_.reset(new char[chunk.capacity_]);
+        }
+        char* dest = chunk.data_.get() + chunk.size_;
+        std::copy(data, data + len, dest);
+        chunk.size_ += len;
+        fields_.push_back(std::string_view(dest, len));
+    }
+
+    inline size_t Size() const {
+        return row_idx_.size();
+    }
+
+    inline RecordView GetRow(size_t i) const {
+        return RecordView(row_idx_[i], fields_.data() + i * attrs_->size(), attrs_);
+    }
+
+private:
+    static constexpr size_t kChunkBytes = 1 << 16;
+
+    struct Chunk {
+        std::unique_ptr<char[]> data_;
+        size_t capacity_ = 0;
+        size_t size_ = 0;
+    };
+
+    const std::vector<std::string>* attrs_ = nullptr;
+    std::vector<size_t> row_idx_;
+    std::vector<std::string_view> fields_;
+    std::vector<Chunk> chunks_;
+    size_t chunk_ = 0;
+};
+
+
 class TableIterator {
 public:
+    virtual ~TableIterator() = default;
+
     virtual bool HasNext() = 0;
 
-    virtual Record Next() = 0;
+    // the next row as a view into buffers of the iterator, valid until the next call
+    virtual RecordView NextView() = 0;
+
+    virtual Record Next() {
+        return NextView().ToRecord();
+    }
+
+    // Replaces the content of batch with up to max_rows next rows and returns their
+    // number, 0 at the end. Rows of the previous batch are invalidated. Don't interleave
+    // with HasNext() / NextView() on the same iterator.
+    virtual size_t NextBatch(RowBatch* batch, size_t max_rows) {
+        const std::vector<std::string>* attrs = nullptr;
+        batch->Clear(attrs);
+        while (batch->Size() < max_rows && HasNext()) {
+            RecordView r = NextView();
+            if (attrs == nullptr) {
+                attrs = &r.GetAttributes();
+                batch->Clear(attrs);
+            }
+            batch->AddRow(r.GetRowIndex());
+            for (size_t i = 0; i < attrs->size(); i++) {
+                std::string_view val = r.GetField(i);
+                batch->CopyField(val.data(), val.size());
+            }
+        }
+        return batch->Size();
+    }
 };
 
 
 class Table {
 public:
+    virtual ~Table() = default;
+
+    virtual std::unique_ptr<TableIterator> GetIterator() = 0;
+
+    // Iterators over disjoint parts of the table in row order, together covering it, each
+    // to be drained by its own thread. At most GetScanThreads() of them, tables without
+    // parallel scans return a single one.
+    virtual std::vector<std::unique_ptr<TableIterator>> GetPartitionedIterators() {
+        std::vector<std::unique_ptr<TableIterator>> iters;
+        iters.push_back(GetIterator());
+        return iters;
+    }
+
+    inline void SetScanThreads(size_t scan_threads) {
+        scan_threads_ = std::max<size_t>(1, scan_threads);
+    }
 
-    virtual TableIterator GetIterator() = 0;
+    inline size_t GetScanThreads() const {
+        return scan_threads_;
+    }
 
-    virtual std::vector<size_t> FindConflict(const Record& r) = 0;
+    virtual std::vector<size_t> FindConflict(const RecordView& r) = 0;
 
-    inline std::vector<std::string> GetTableAttrbutes() const {
+    virtual Record GetRecord(size_t row_idx) = 0;
+
+    virtual size_t GetTotalRowNum() = 0;
+
+    // One past the largest row index. Row indexes are the graph's node ids, dense
+    // 0..n-1 except on SqliteTable, whose rowids start at 1 and may have gaps; it throws
+    // rather than return a bound far beyond the row count.
+    virtual size_t GetRowIndexBound() {
+        return GetTotalRowNum();
+    }
+
+    // attributes of scanned rows, records and views: the projection if one is set
+    inline const std::vector<std::string>& GetTableAttrbutes() const {
     	return attrs_;
     }
 
-    inline void SetTableName(const std::string& tablename): tablename_(tablename) {}
+    // every attribute of the table regardless of the projection
+    inline const std::vector<std::string>& GetSchemaAttributes() const {
+        return schema_attrs_.empty() ? attrs_ : schema_attrs_;
+    }
 
-    inline void LoadFunctionalDependencies(const std::vector<FunctionalDependency>& fds): fds_(fds) {}
+    // Restricts scans, records and views to attrs, kept in schema order, so backends read
+    // only those columns. Empty restores every column. Find() still sees all columns.
+    void SetProjection(const std::vector<std::string>& attrs) {
+        if (schema_attrs_.empty()) {
+            schema_attrs_ = attrs_;
+        }
+        attrs_.clear();
+        attr_cols_.clear();
+        for (const std::string& attr: attrs) {
+            if (std::find(schema_attrs_.begin(), schema_attrs_.end(), attr) == schema_attrs_.end()) {
+                throw "Projected attribute not in table!";
+            }
+        }
+        for (size_t col = 0; col < schema_attrs_.size(); col++) {
+            if (attrs.empty() || std::find(attrs.begin(), attrs.end(), schema_attrs_[col]) != attrs.end()) {
+                attrs_.push_back(schema_attrs_[col]);
+                attr_cols_.push_back(col);
+            }
+        }
+    }
+
+    // Projection onto the attributes of the loaded FDs plus extra_attrs, e.g. the ones of
+    // SubsetQuery::GetAttributes(). Extra attributes the table lacks are skipped, the
+    // Oracle rejects queries on them.
+    void ProjectOnDependencies(const std::vector<std::string>& extra_attrs = std::vector<std::string>()) {
+        const std::vector<std::string>& schema = GetSchemaAttributes();
+        std::vector<std::string> attrs;
+        for (const std::string& attr: extra_attrs) {
+            if (std::find(schema.begin(), schema.end(), attr) != schema.end()) {
+                attrs.push_back(attr);
+            }
+        }
+        for (const FunctionalDependency& fd: fds_) {
+            for (const std::string& attr: fd.GetLeftHandAttrs()) {
+                attrs.push_back(attr);
+            }
+            for (const std::string& attr: fd.GetRightHandAttrs()) {
+                attrs.push_back(attr);
+            }
+        }
+        SetProjection(attrs);
+    }
+
+    inline void SetTableName(const std::string& tablename) {
+        tablename_ = tablename;
+    }
+
+    inline void LoadFunctionalDependencies(const std::vector<FunctionalDependency>& fds) {
+        fds_ = fds;
+    }
 
-    virtual std::vector<size_t> Find(SubsetQuery&) = 0;
+    virtual std::vector<size_t> Find(const SubsetQuery&) = 0;
+
+    // rows satisfying the query as a bitmap, tables with bitmap indexes build it directly
+    virtual Bitmap FindMembership(const SubsetQuery& query) {
+        Bitmap membership;
+        for (size_t row_idx: Find(query)) {
+            membership.Set(row_idx);
+        }
+        return membership;
+    }
+
+    inline const std::vector<FunctionalDependency>& GetFunctionalDependencies() const {
+        return fds_;
+    }
 
     inline std::string GetTableName() {
         return tablename_;
     }
 
+    // changes whenever rows change, results cached under an older version are stale
+    virtual uint64_t GetVersion() {
+        return version_;
+    }
+
+    // unique per table object in the process, never reused unlike its address
+    inline uint64_t GetInstanceId() const {
+        return instance_id_;
+    }
+
 protected:
+    // position in GetSchemaAttributes() of attribute col of attrs_
+    inline size_t SchemaColumn(size_t col) const {
+        return attr_cols_.empty() ? col : attr_cols_[col];
+    }
+
+    uint64_t version_ = 0;
+    size_t scan_threads_ = 1;
+    // full schema once a projection is set, empty before
+    std::vector<std::string> schema_attrs_;
+    std::vector<size_t> attr_cols_;
 	std::unordered_map<std::string, std::string> schema_;
+	std::vector<std::string> attrs_;
 	std::vector<FunctionalDependency> fds_;
     std::string tablename_;
+
+private:
+    static uint64_t NextInstanceId() {
+        static std::atomic<uint64_t> next_id(0);
+        return next_id++;
+    }
+
+    uint64_t instance_id_ = NextInstanceId();
 };
 
 }  // dcr
@@ -0,0 +1,21 @@
+#ifndef DCR_CORE_TYPES_H_
+#define DCR_CORE_TYPES_H_
+
+#include <cstdint>
+
+namespace dcr {
+
+// Id widths of the conflict graph. 32 bits cover tables up to 2^32 - 1 rows and keep an
+// adjacency entry at 16 bytes; build with DCR_64BIT_IDS for larger tables.
+#ifdef DCR_64BIT_IDS
+typedef uint64_t NodeId;
+typedef uint64_t EdgeId;
+typedef uint64_t EdgeRank;
+#else
+typedef uint32_t NodeId;
+typedef uint32_t EdgeId;
+typedef uint32_t EdgeRank;
+#endif
+
+}  // dcr
+#endif  // DCR_CORE_TYPES_H_
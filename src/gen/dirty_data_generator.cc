@@ -0,0 +1,143 @@
+#include "gen/dirty_data_generator.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+namespace dcr {
+using std::string;
+using std::vector;
+using std::unordered_map;
+
+
+DirtyDataGenerator::DirtyDataGenerator(const GeneratorSpec& spec): spec_(spec), gen_(spec.seed_),
+        uniform_(0.0, 1.0), row_idx_(0) {
+    if (spec_.lhs_groups_ == 0) {
+        throw "Generator needs at least one LHS group!";
+    }
+
+    std::unordered_set<string> seen;
+    for (const FunctionalDependency& fd: spec_.fds_) {
+        vector<size_t> lhs, rhs;
+        for (const string& attr: fd.GetLeftHandAttrs()) {
+            if (!seen.insert(attr).second) {
+                throw "Generator needs FDs over disjoint attributes!";
+            }
+            lhs.push_back(attrs_.size());
+            attrs_.push_back(attr);
+        }
+        for (const string& attr: fd.GetRightHandAttrs()) {
+            if (!seen.insert(attr).second) {
+                throw "Generator needs FDs over disjoint attributes!";
+            }
+            rhs.push_back(attrs_.size());
+            attrs_.push_back(attr);
+        }
+        lhs_pos_.push_back(lhs);
+        rhs_pos_.push_back(rhs);
+    }
+    for (const string& attr: spec_.extra_attrs_) {
+        if (!seen.insert(attr).second) {
+            throw "Duplicate attribute in generator spec!";
+        }
+        extra_pos_.push_back(attrs_.size());
+        attrs_.push_back(attr);
+    }
+
+    if (spec_.group_distribution_ == GroupDistribution::kZipfian) {
+        zipf_cdf_.resize(spec_.lhs_groups_);
+        double total = 0.0;
+        for (size_t i = 0; i < spec_.lhs_groups_; i++) {
+            total += 1.0 / pow((double)(i + 1), spec_.zipf_exponent_);
+            zipf_cdf_[i] = total;
+        }
+        for (double& p: zipf_cdf_) {
+            p /= total;
+        }
+    }
+
+    track_cover_ = spec_.fds_.size() == 1;
+    if (track_cover_) {
+        group_rows_.assign(spec_.lhs_groups_, 0);
+    }
+}
+
+size_t DirtyDataGenerator::Cardinality(const string& attr) const {
+    auto iter = spec_.cardinalities_.find(attr);
+    size_t card = iter == spec_.cardinalities_.end() ? spec_.default_cardinality_ : iter->second;
+    return std::max<size_t>(card, 1);
+}
+
+size_t DirtyDataGenerator::SampleGroup() {
+    if (spec_.group_distribution_ == GroupDistribution::kUniform) {
+        return gen_() % spec_.lhs_groups_;
+    }
+    double u = uniform_(gen_);
+    size_t g = std::upper_bound(zipf_cdf_.begin(), zipf_cdf_.end(), u) - zipf_cdf_.begin();
+    return std::min(g, spec_.lhs_groups_ - 1);
+}
+
+void DirtyDataGenerator::Next(vector<string>* values) {
+    values->resize(attrs_.size());
+    for (size_t pos: extra_pos_) {
+        (*values)[pos] = "e" + std::to_string(gen_() % Cardinality(attrs_[pos]));
+    }
+
+    for (size_t f = 0; f < spec_.fds_.size(); f++) {
+        size_t g = SampleGroup();
+        // the first LHS attribute identifies the group, the others are derived from it
+        for (size_t j = 0; j < lhs_pos_[f].size(); j++) {
+            size_t pos = lhs_pos_[f][j];
+            size_t val = j == 0 ? g : (g * 2654435761ULL + j) % Cardinality(attrs_[pos]);
+            (*values)[pos] = "g" + std::to_string(val);
+        }
+
+        vector<size_t> rhs_vals(rhs_pos_[f].size());
+        for (size_t k = 0; k < rhs_pos_[f].size(); k++) {
+            rhs_vals[k] = (g * 31 + k * 17) % Cardinality(attrs_[rhs_pos_[f][k]]);
+        }
+        bool dirty = false;
+        if (uniform_(gen_) < spec_.violation_rate_) {
+            size_t k = gen_() % rhs_vals.size();
+            size_t card = Cardinality(attrs_[rhs_pos_[f][k]]);
+            if (card > 1) {
+                rhs_vals[k] = (rhs_vals[k] + 1 + gen_() % (card - 1)) % card;
+                dirty = true;
+            }
+        }
+
+        string part;
+        for (size_t k = 0; k < rhs_pos_[f].size(); k++) {
+            (*values)[rhs_pos_[f][k]] = "v" + std::to_string(rhs_vals[k]);
+            part += (*values)[rhs_pos_[f][k]];
+            part += '\x1f';
+        }
+        if (track_cover_) {
+            group_rows_[g]++;
+            if (dirty) {
+                dirty_parts_[g][part]++;
+            }
+        }
+    }
+    row_idx_++;
+}
+
+bool DirtyDataGenerator::MinimumVertexCoverSize(size_t* size) const {
+    if (!track_cover_) {
+        return false;
+    }
+    size_t cover = 0;
+    for (const auto& kv: dirty_parts_) {
+        size_t rows = group_rows_[kv.first];
+        size_t dirty = 0, largest = 0;
+        for (const auto& part: kv.second) {
+            dirty += part.second;
+            largest = std::max(largest, part.second);
+        }
+        largest = std::max(largest, rows - dirty);
+        cover += rows - largest;
+    }
+    *size = cover;
+    return true;
+}
+
+}  // dcr
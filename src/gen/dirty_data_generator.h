@@ -0,0 +1,84 @@
+#ifndef DCR_GEN_DIRTY_DATA_GENERATOR_H_
+#define DCR_GEN_DIRTY_DATA_GENERATOR_H_
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "core/table.h"
+
+namespace dcr {
+
+enum class GroupDistribution {
+    kUniform,
+    kZipfian
+};
+
+struct GeneratorSpec {
+    size_t rows_ = 0;
+    // attribute sets of different FDs must be disjoint
+    std::vector<FunctionalDependency> fds_;
+    // fraction of rows whose RHS of an FD is replaced by a value disagreeing with the group
+    double violation_rate_ = 0.0;
+    // number of distinct LHS values per FD and how rows are spread over them
+    size_t lhs_groups_ = 1000;
+    GroupDistribution group_distribution_ = GroupDistribution::kUniform;
+    double zipf_exponent_ = 1.0;
+    // attributes not mentioned by any FD
+    std::vector<std::string> extra_attrs_;
+    // domain size per attribute, attributes without an entry use default_cardinality_
+    std::unordered_map<std::string, size_t> cardinalities_;
+    size_t default_cardinality_ = 1000;
+    uint64_t seed_ = 42;
+};
+
+
+// Streams rows of a table violating the given FDs at a controlled rate. Only O(lhs_groups)
+// state is kept, plus O(violations) when the exact minimum vertex cover is tracked.
+class DirtyDataGenerator {
+public:
+    explicit DirtyDataGenerator(const GeneratorSpec& spec);
+
+    inline const std::vector<std::string>& GetAttributes() const {
+        return attrs_;
+    }
+
+    inline bool HasNext() const {
+        return row_idx_ < spec_.rows_;
+    }
+
+    // fills values in the order of GetAttributes()
+    void Next(std::vector<std::string>* values);
+
+    // With a single FD the conflict graph is a disjoint union of complete multipartite
+    // graphs (one per LHS group, parts are RHS values), its minimum vertex cover keeps the
+    // largest part of every group. Returns false when it is not computable.
+    bool MinimumVertexCoverSize(size_t* size) const;
+
+private:
+    size_t SampleGroup();
+
+    size_t Cardinality(const std::string& attr) const;
+
+    GeneratorSpec spec_;
+    std::vector<std::string> attrs_;
+    // per FD: positions of LHS / RHS attributes in attrs_
+    std::vector<std::vector<size_t>> lhs_pos_;
+    std::vector<std::vector<size_t>> rhs_pos_;
+    std::vector<size_t> extra_pos_;
+
+    std::mt19937_64 gen_;
+    std::uniform_real_distribution<double> uniform_;
+    // cumulative group probabilities for the Zipfian distribution
+    std::vector<double> zipf_cdf_;
+    size_t row_idx_;
+
+    // single-FD ground truth: rows per group and, per group, the sizes of the dirty RHS parts
+    bool track_cover_;
+    std::vector<size_t> group_rows_;
+    std::unordered_map<size_t, std::unordered_map<std::string, size_t>> dirty_parts_;
+};
+
+}  // dcr
+#endif  // DCR_GEN_DIRTY_DATA_GENERATOR_H_
@@ -0,0 +1,96 @@
+#include "gen/row_sink.h"
+#include <string>
+#include <vector>
+
+namespace dcr {
+using std::string;
+using std::vector;
+
+
+static void WriteCsvField(std::ofstream& out, const string& val) {
+	if (val.find_first_of(",\"\n") == string::npos) {
+		out << val;
+		return;
+	}
+	out << '"';
+	for (char c: val) {
+		if (c == '"') {
+			out << '"';
+		}
+		out << c;
+	}
+	out << '"';
+}
+
+CsvSink::CsvSink(const string& filename, const vector<string>& attrs): out_(filename) {
+	if (!out_) {
+		throw "Can't open csv file!";
+	}
+	Write(attrs);
+}
+
+void CsvSink::Write(const vector<string>& values) {
+	for (size_t i = 0; i < values.size(); i++) {
+		if (i != 0) {
+			out_ << ',';
+		}
+		WriteCsvField(out_, values[i]);
+	}
+	out_ << '\n';
+}
+
+void CsvSink::Close() {
+	if (out_.is_open()) {
+		out_.close();
+	}
+}
+
+SqliteSink::SqliteSink(const string& filename, const string& tablename, const vector<string>& attrs,
+		size_t batch_rows): db_(NULL), stmt_(NULL), batch_rows_(batch_rows), pending_(0) {
+	if (sqlite3_open(filename.c_str(), &db_) != SQLITE_OK) {
+		throw "Can't open database file!";
+	}
+	sqlite3_exec(db_, "PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF;", NULL, NULL, NULL);
+
+	string create = "CREATE TABLE " + tablename + " (";
+	string insert = "INSERT INTO " + tablename + " VALUES (";
+	for (size_t i = 0; i < attrs.size(); i++) {
+		create += (i == 0 ? "" : ", ") + attrs[i] + " TEXT";
+		insert += i == 0 ? "?" : ", ?";
+	}
+	create += ")";
+	insert += ")";
+	if (sqlite3_exec(db_, create.c_str(), NULL, NULL, NULL) != SQLITE_OK) {
+		throw "Create table failed!";
+	}
+	if (sqlite3_prepare_v2(db_, insert.c_str(), insert.size(), &stmt_, NULL) != SQLITE_OK) {
+		throw "Fail to prepare insert!";
+	}
+	sqlite3_exec(db_, "BEGIN", NULL, NULL, NULL);
+}
+
+void SqliteSink::Write(const vector<string>& values) {
+	for (size_t i = 0; i < values.size(); i++) {
+		sqlite3_bind_text(stmt_, i + 1, values[i].c_str(), values[i].size(), SQLITE_TRANSIENT);
+	}
+	if (sqlite3_step(stmt_) != SQLITE_DONE) {
+		throw "Fail to insert row!";
+	}
+	sqlite3_reset(stmt_);
+	if (++pending_ >= batch_rows_) {
+		sqlite3_exec(db_, "COMMIT; BEGIN", NULL, NULL, NULL);
+		pending_ = 0;
+	}
+}
+
+void SqliteSink::Close() {
+	if (db_ == NULL) {
+		return;
+	}
+	sqlite3_exec(db_, "COMMIT", NULL, NULL, NULL);
+	sqlite3_finalize(stmt_);
+	sqlite3_close(db_);
+	db_ = NULL;
+}
+
+}  // dcr
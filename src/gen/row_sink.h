@@ -0,0 +1,61 @@
+#ifndef DCR_GEN_ROW_SINK_H_
+#define DCR_GEN_ROW_SINK_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "sqlite3.h"
+
+namespace dcr {
+
+// Destination of generated rows, written one at a time.
+class RowSink {
+public:
+    virtual ~RowSink() = default;
+
+    virtual void Write(const std::vector<std::string>& values) = 0;
+
+    virtual void Close() = 0;
+};
+
+
+class CsvSink: public RowSink {
+public:
+    CsvSink(const std::string& filename, const std::vector<std::string>& attrs);
+
+    ~CsvSink() {
+        Close();
+    }
+
+    void Write(const std::vector<std::string>& values);
+
+    void Close();
+
+private:
+    std::ofstream out_;
+};
+
+
+// Inserts through one prepared statement, committing every batch_rows rows.
+class SqliteSink: public RowSink {
+public:
+    SqliteSink(const std::string& filename, const std::string& tablename, const std::vector<std::string>& attrs,
+            size_t batch_rows = 100000);
+
+    ~SqliteSink() {
+        Close();
+    }
+
+    void Write(const std::vector<std::string>& values);
+
+    void Close();
+
+private:
+    sqlite3* db_;
+    sqlite3_stmt* stmt_;
+    size_t batch_rows_;
+    size_t pending_;
+};
+
+}  // dcr
+#endif  // DCR_GEN_ROW_SINK_H_
@@ -0,0 +1,255 @@
+#include "io/arrow_table.h"
+#include <algorithm>
+#include <unordered_set>
+#include <arrow/compute/cast.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/reader.h>
+#include <parquet/arrow/reader.h>
+
+
+namespace dcr {
+using std::shared_ptr;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+
+static bool EndsWith(const string& s, const string& suffix) {
+	return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// field positions of projection in schema, every field when projection is empty
+static vector<int> ProjectFields(const arrow::Schema& schema, const vector<string>& projection) {
+	vector<int> fields;
+	if (projection.empty()) {
+		for (int i = 0; i < schema.num_fields(); i++) {
+			fields.push_back(i);
+		}
+		return fields;
+	}
+	for (const string& attr: projection) {
+		int idx = schema.GetFieldIndex(attr);
+		if (idx == -1) {
+			throw "Projected attribute not in arrow schema!";
+		}
+		fields.push_back(idx);
+	}
+	std::sort(fields.begin(), fields.end());
+	fields.erase(std::unique(fields.begin(), fields.end()), fields.end());
+	return fields;
+}
+
+ArrowTable::ArrowTable(const string& filename, const string& tablename, const vector<string>& projection) {
+	tablename_ = tablename;
+	if (EndsWith(filename, ".parquet")) {
+		LoadParquet(filename, projection);
+	} else {
+		LoadIpc(filename, projection);
+	}
+}
+
+void ArrowTable::LoadIpc(const string& filename, const vector<string>& projection) {
+	arrow::Result<shared_ptr<arrow::io::MemoryMappedFile>> file =
+		arrow::io::MemoryMappedFile::Open(filename, arrow::io::FileMode::READ);
+	if (!file.ok()) {
+		throw "Can't open arrow file!";
+	}
+	arrow::Result<shared_ptr<arrow::ipc::RecordBatchFileReader>> reader =
+		arrow::ipc::RecordBatchFileReader::Open(*file);
+	if (!reader.ok()) {
+		throw "Invalid arrow ipc file!";
+	}
+	// batches are read from the mapping, projected columns only
+	arrow::ipc::IpcReadOptions options = arrow::ipc::IpcReadOptions::Defaults();
+	options.included_fields = ProjectFields(*(*reader)->schema(), projection);
+	reader = arrow::ipc::RecordBatchFileReader::Open(*file, options);
+	if (!reader.ok()) {
+		throw "Invalid arrow ipc file!";
+	}
+	for (const shared_ptr<arrow::Field>& field: (*reader)->schema()->fields()) {
+		attrs_.push_back(field->name());
+	}
+	for (int i = 0; i < (*reader)->num_record_batches(); i++) {
+		arrow::Result<shared_ptr<arrow::RecordBatch>> batch = (*reader)->ReadRecordBatch(i);
+		if (!batch.ok()) {
+			throw "Fail to read arrow record batch!";
+		}
+		AddBatch(*batch);
+	}
+}
+
+void ArrowTable::LoadParquet(const string& filename, const vector<string>& projection) {
+	arrow::Result<shared_ptr<arrow::io::ReadableFile>> file = arrow::io::ReadableFile::Open(filename);
+	if (!file.ok()) {
+		throw "Can't open parquet file!";
+	}
+	parquet::arrow::FileReaderBuilder builder;
+	std::unique_ptr<parquet::arrow::FileReader> reader;
+	if (!builder.Open(*file).ok() || !builder.Build(&reader).ok()) {
+		throw "Invalid parquet file!";
+	}
+	shared_ptr<arrow::Schema> schema;
+	if (!reader->GetSchema(&schema).ok()) {
+		throw "Invalid parquet file!";
+	}
+	// flat schemas only, field i is leaf column i
+	vector<int> fields = ProjectFields(*schema, projection);
+	shared_ptr<arrow::Table> table;
+	if (!reader->ReadTable(fields, &table).ok()) {
+		throw "Fail to read parquet file!";
+	}
+	for (const shared_ptr<arrow::Field>& field: table->schema()->fields()) {
+		attrs_.push_back(field->name());
+	}
+	// re-slices the column chunks into aligned record batches without copying
+	arrow::TableBatchReader batch_reader(*table);
+	shared_ptr<arrow::RecordBatch> batch;
+	while (batch_reader.ReadNext(&batch).ok() && batch != nullptr) {
+		AddBatch(batch);
+	}
+}
+
+void ArrowTable::AddBatch(const shared_ptr<arrow::RecordBatch>& batch) {
+	vector<shared_ptr<arrow::Array>> columns;
+	for (int i = 0; i < batch->num_columns(); i++) {
+		shared_ptr<arrow::Array> column = batch->column(i);
+		arrow::Type::type type = column->type_id();
+		if (type != arrow::Type::STRING && type != arrow::Type::LARGE_STRING) {
+			arrow::Result<shared_ptr<arrow::Array>> cast = arrow::compute::Cast(*column, arrow::utf8());
+			if (!cast.ok()) {
+				throw "Fail to convert arrow column to strings!";
+			}
+			column = *cast;
+		}
+		columns.push_back(column);
+	}
+	if (batch->num_rows() == 0) {
+		return;
+	}
+	batch_offsets_.push_back(row_num_);
+	batches_.push_back(std::move(columns));
+	row_num_ += batch->num_rows();
+}
+
+size_t ArrowTable::BatchOf(size_t row_idx) const {
+	return std::upper_bound(batch_offsets_.begin(), batch_offsets_.end(), row_idx) - batch_offsets_.begin() - 1;
+}
+
+std::string_view ArrowTable::GetValue(size_t row_idx, size_t col) const {
+	size_t b = BatchOf(row_idx);
+	return ValueAt(*batches_[b][SchemaColumn(col)], row_idx - batch_offsets_[b]);
+}
+
+std::string_view ArrowTable::GetSchemaValue(size_t row_idx, size_t col) const {
+	size_t b = BatchOf(row_idx);
+	return ValueAt(*batches_[b][col], row_idx - batch_offsets_[b]);
+}
+
+std::string_view ArrowTable::ValueAt(const arrow::Array& column, int64_t pos) {
+	if (column.IsNull(pos)) {
+		return std::string_view();
+	}
+	if (column.type_id() == arrow::Type::LARGE_STRING) {
+		return static_cast<const arrow::LargeStringArray&>(column).GetView(pos);
+	}
+	return static_cast<const arrow::StringArray&>(column).GetView(pos);
+}
+
+void ArrowTable::FillBatch(size_t begin, size_t end, RowBatch* batch) const {
+	batch->Clear(&attrs_);
+	for (size_t row = begin; row < end; row++) {
+		size_t b = BatchOf(row);
+		batch->AddRow(row);
+		for (size_t col = 0; col < attrs_.size(); col++) {
+			batch->AddField(ValueAt(*batches_[b][SchemaColumn(col)], row - batch_offsets_[b]));
+		}
+	}
+}
+
+std::unique_ptr<TableIterator> ArrowTable::GetIterator() {
+	return std::unique_ptr<TableIterator>(new ArrowTableIterator(this, &attrs_, 0, row_num_));
+}
+
+vector<std::unique_ptr<TableIterator>> ArrowTable::GetPartitionedIterators() {
+	vector<std::unique_ptr<TableIterator>> iters;
+	size_t parts = std::max<size_t>(1, std::min(scan_threads_, row_num_));
+	for (size_t i = 0; i < parts; i++) {
+		iters.emplace_back(new ArrowTableIterator(this, &attrs_, row_num_ * i / parts, row_num_ * (i + 1) / parts));
+	}
+	return iters;
+}
+
+Record ArrowTable::GetRecord(size_t row_idx) {
+	unordered_map<string, string> content;
+	for (size_t i = 0; i < attrs_.size(); i++) {
+		content[attrs_[i]] = string(GetValue(row_idx, i));
+	}
+	return Record(row_idx, content);
+}
+
+void ArrowTable::BuildConflictIndex() {
+	lhs_index_.assign(fds_.size(), unordered_map<string, vector<size_t>>());
+	for (size_t f = 0; f < fds_.size(); f++) {
+		vector<size_t> cols = fds_[f].GetLeftHandColumns(GetSchemaAttributes());
+		for (size_t row = 0; row < row_num_; row++) {
+			string key;
+			for (size_t col: cols) {
+				std::string_view val = GetSchemaValue(row, col);
+				key.append(val.data(), val.size());
+				key += '\x1f';
+			}
+			lhs_index_[f][key].push_back(row);
+		}
+	}
+	indexed_fd_num_ = fds_.size();
+}
+
+vector<size_t> ArrowTable::FindConflict(const RecordView& r) {
+	if (indexed_fd_num_ != fds_.size()) {
+		BuildConflictIndex();
+	}
+
+	std::unordered_set<size_t> res;
+	for (size_t f = 0; f < fds_.size(); f++) {
+		string key;
+		for (const string& attr: fds_[f].GetLeftHandAttrs()) {
+			std::string_view val = r.GetField(attr);
+			key.append(val.data(), val.size());
+			key += '\x1f';
+		}
+		auto iter = lhs_index_[f].find(key);
+		if (iter == lhs_index_[f].end()) {
+			continue;
+		}
+		vector<string> rhs_attrs = fds_[f].GetRightHandAttrs();
+		vector<size_t> rhs_cols = fds_[f].GetRightHandColumns(GetSchemaAttributes());
+		for (size_t row: iter->second) {
+			for (size_t i = 0; i < rhs_cols.size(); i++) {
+				if (GetSchemaValue(row, rhs_cols[i]) != r.GetField(rhs_attrs[i])) {
+					res.insert(row);
+					break;
+				}
+			}
+		}
+	}
+
+	return vector<size_t>(res.begin(), res.end());
+}
+
+vector<size_t> ArrowTable::Find(const SubsetQuery& query) {
+	vector<size_t> res;
+	vector<int32_t> columns = query.ResolveColumns(GetSchemaAttributes());
+	for (size_t b = 0; b < batches_.size(); b++) {
+		const vector<shared_ptr<arrow::Array>>& batch = batches_[b];
+		size_t rows = b + 1 < batches_.size() ? batch_offsets_[b + 1] - batch_offsets_[b] : row_num_ - batch_offsets_[b];
+		for (size_t pos = 0; pos < rows; pos++) {
+			if (query.Satisfy(columns, [&](size_t col) { return ValueAt(*batch[col], pos); })) {
+				res.push_back(batch_offsets_[b] + pos);
+			}
+		}
+	}
+	return res;
+}
+
+
+}  // dcr
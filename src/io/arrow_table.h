@@ -0,0 +1,118 @@
+#ifndef DCR_IO_ARROW_TABLE_H_
+#define DCR_IO_ARROW_TABLE_H_
+
+#ifdef DCR_WITH_ARROW
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <arrow/api.h>
+#include "core/table.h"
+#include "core/subset_query.h"
+
+namespace dcr {
+
+class Table;
+class SubsetQuery;
+
+// Read-only table over an Arrow IPC file (.arrow / .feather, memory mapped) or a Parquet
+// file, rows are indexed from 0. Only the projected columns are read; values are served
+// as views into the Arrow buffers, so IPC input is not copied at all. Columns that are
+// not strings are cast to utf8 once on load.
+class ArrowTable: public Table {
+public:
+    // projection lists the attributes to read, empty reads every column
+    ArrowTable(const std::string& filename, const std::string& tablename,
+            const std::vector<std::string>& projection = std::vector<std::string>());
+
+    ArrowTable() = delete;
+
+    std::unique_ptr<TableIterator> GetIterator();
+
+    // contiguous row ranges
+    std::vector<std::unique_ptr<TableIterator>> GetPartitionedIterators();
+
+    std::vector<size_t> FindConflict(const RecordView& r);
+
+    std::vector<size_t> Find(const SubsetQuery&);
+
+    Record GetRecord(size_t row_idx);
+
+    size_t GetTotalRowNum() {
+        return row_num_;
+    }
+
+    // value of attribute col of GetTableAttrbutes(), empty for null values
+    std::string_view GetValue(size_t row_idx, size_t col) const;
+
+    // value of attribute col of GetSchemaAttributes(), i.e. of the columns read on load
+    std::string_view GetSchemaValue(size_t row_idx, size_t col) const;
+
+    // appends rows [begin, end) to batch as views into the Arrow buffers
+    void FillBatch(size_t begin, size_t end, RowBatch* batch) const;
+
+private:
+    void LoadIpc(const std::string& filename, const std::vector<std::string>& projection);
+
+    void LoadParquet(const std::string& filename, const std::vector<std::string>& projection);
+
+    // keeps the columns of batch, each cast to a string type
+    void AddBatch(const std::shared_ptr<arrow::RecordBatch>& batch);
+
+    // batch holding row_idx, rows of batch b start at batch_offsets_[b]
+    size_t BatchOf(size_t row_idx) const;
+
+    static std::string_view ValueAt(const arrow::Array& column, int64_t pos);
+
+    void BuildConflictIndex();
+
+    // columns of every record batch
+    std::vector<std::vector<std::shared_ptr<arrow::Array>>> batches_;
+    std::vector<size_t> batch_offsets_;
+    size_t row_num_ = 0;
+
+    // per FD: concatenated LHS values -> rows
+    std::vector<std::unordered_map<std::string, std::vector<size_t>>> lhs_index_;
+    size_t indexed_fd_num_ = 0;
+};
+
+
+class ArrowTableIterator: public TableIterator {
+public:
+    // rows [begin, end)
+    ArrowTableIterator(const ArrowTable* table, const std::vector<std::string>* attrs, size_t begin, size_t end):
+            table_(table), attrs_(attrs), pos_(begin), end_(end), fields_(attrs->size()) {}
+
+    bool HasNext() {
+        return pos_ < end_;
+    }
+
+    RecordView NextView() {
+        for (size_t i = 0; i < fields_.size(); i++) {
+            fields_[i] = table_->GetValue(pos_, i);
+        }
+        return RecordView(pos_++, fields_.data(), attrs_);
+    }
+
+    size_t NextBatch(RowBatch* batch, size_t max_rows) {
+        size_t end = std::min(end_, pos_ + max_rows);
+        table_->FillBatch(pos_, end, batch);
+        pos_ = end;
+        return batch->Size();
+    }
+
+private:
+    const ArrowTable* table_;
+    const std::vector<std::string>* attrs_;
+    size_t pos_;
+    size_t end_;
+    std::vector<std::string_view> fields_;
+};
+
+}  // dcr
+
+#endif  // DCR_WITH_ARROW
+#endif  // DCR_IO_ARROW_TABLE_H_
@@ -0,0 +1,261 @@
+#include "io/memory_table.h"
+#include <algorithm>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "core/table.h"
+
+
+namespace dcr {
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+
+static string JoinFields(const RecordView& r, const vector<string>& attrs) {
+	string key;
+	for (const string& attr: attrs) {
+		std::string_view val = r.GetField(attr);
+		key.append(val.data(), val.size());
+		key += '\x1f';
+	}
+	return key;
+}
+
+void MemoryTable::AppendRow(const vector<string>& values) {
+	if (values.size() != columns_.size()) {
+		throw "Row does not match table attributes!";
+	}
+	for (size_t i = 0; i < values.size(); i++) {
+		columns_[i].push_back(values[i]);
+	}
+	row_num_++;
+	version_++;
+}
+
+std::unique_ptr<TableIterator> MemoryTable::GetIterator() {
+	return std::unique_ptr<TableIterator>(new MemoryTableIterator(this));
+}
+
+vector<std::unique_ptr<TableIterator>> MemoryTable::GetPartitionedIterators() {
+	vector<std::unique_ptr<TableIterator>> iters;
+	size_t parts = std::max<size_t>(1, std::min(scan_threads_, row_num_));
+	for (size_t i = 0; i < parts; i++) {
+		iters.emplace_back(new MemoryTableIterator(this, row_num_ * i / parts, row_num_ * (i + 1) / parts));
+	}
+	return iters;
+}
+
+Record MemoryTable::GetRecord(size_t row_idx) {
+	unordered_map<string, string> content;
+	for (size_t i = 0; i < attrs_.size(); i++) {
+		content[attrs_[i]] = columns_[SchemaColumn(i)][row_idx];
+	}
+	return Record(row_idx, content);
+}
+
+void MemoryTable::BuildConflictIndex() {
+	lhs_index_.assign(fds_.size(), unordered_map<string, vector<size_t>>());
+	for (size_t f = 0; f < fds_.size(); f++) {
+		vector<size_t> cols;
+		for (const string& attr: fds_[f].GetLeftHandAttrs()) {
+			cols.push_back(column_idx_.at(attr));
+		}
+		for (size_t row = 0; row < row_num_; row++) {
+			string key;
+			for (size_t col: cols) {
+				key += columns_[col][row];
+				key += '\x1f';
+			}
+			lhs_index_[f][key].push_back(row);
+		}
+	}
+	indexed_row_num_ = row_num_;
+	indexed_fd_num_ = fds_.size();
+}
+
+vector<size_t> MemoryTable::FindConflict(const RecordView& r) {
+	if (indexed_row_num_ != row_num_ || indexed_fd_num_ != fds_.size()) {
+		BuildConflictIndex();
+	}
+
+	std::unordered_set<size_t> res;
+	for (size_t f = 0; f < fds_.size(); f++) {
+		auto iter = lhs_index_[f].find(JoinFields(r, fds_[f].GetLeftHandAttrs()));
+		if (iter == lhs_index_[f].end()) {
+			continue;
+		}
+		vector<string> rhs_attrs = fds_[f].GetRightHandAttrs();
+		vector<size_t> rhs_cols = fds_[f].GetRightHandColumns(GetSchemaAttributes());
+		vector<std::string_view> rhs;
+		for (const string& attr: rhs_attrs) {
+			rhs.push_back(r.GetField(attr));
+		}
+		for (size_t row: iter->second) {
+			for (size_t i = 0; i < rhs_cols.size(); i++) {
+				if (columns_[rhs_cols[i]][row] != rhs[i]) {
+					res.insert(row);
+					break;
+				}
+			}
+		}
+	}
+
+	return vector<size_t>(res.begin(), res.end());
+}
+
+void MemoryTable::UpdateZoneMaps() {
+	// only the trailing block can have grown, full blocks are final
+	size_t first_block = zoned_row_num_ / kBlockRows;
+	zone_maps_.resize((row_num_ + kBlockRows - 1) / kBlockRows);
+	for (size_t b = first_block; b < zone_maps_.size(); b++) {
+		size_t begin = b * kBlockRows;
+		size_t end = std::min(row_num_, begin + kBlockRows);
+		ZoneMap& zone = zone_maps_[b];
+		zone.min_.assign(columns_.size(), string());
+		zone.max_.assign(columns_.size(), string());
+		zone.distinct_.assign(columns_.size(), 0);
+		for (size_t col = 0; col < columns_.size(); col++) {
+			const vector<string>& column = columns_[col];
+			auto bounds = std::minmax_element(column.begin() + begin, column.begin() + end);
+			zone.min_[col] = *bounds.first;
+			zone.max_[col] = *bounds.second;
+			std::unordered_set<std::string_view> values(column.begin() + begin, column.begin() + end);
+			zone.distinct_[col] = values.size();
+		}
+	}
+	zoned_row_num_ = row_num_;
+}
+
+const vector<MemoryTable::ZoneMap>& MemoryTable::GetZoneMaps() {
+	if (zoned_row_num_ != row_num_) {
+		UpdateZoneMaps();
+	}
+	return zone_maps_;
+}
+
+bool MemoryTable::CreateBitmapIndex(const string& attr, size_t max_distinct) {
+	auto col = column_idx_.find(attr);
+	if (col == column_idx_.end()) {
+		throw "Unknown attribute for bitmap index!";
+	}
+	BitmapIndex index;
+	index.max_distinct_ = max_distinct;
+	if (!UpdateBitmapIndex(col->second, &index)) {
+		return false;
+	}
+	bitmap_indexes_[col->second] = std::move(index);
+	return true;
+}
+
+bool MemoryTable::UpdateBitmapIndex(size_t col, BitmapIndex* index) {
+	const vector<string>& column = columns_[col];
+	for (size_t row = index->indexed_row_num_; row < row_num_; row++) {
+		index->values_[column[row]].Set(row);
+		if (index->values_.size() > index->max_distinct_) {
+			return false;
+		}
+	}
+	index->indexed_row_num_ = row_num_;
+	return true;
+}
+
+Bitmap MemoryTable::FindMembership(const SubsetQuery& query) {
+	if (query.Empty() || bitmap_indexes_.empty()) {
+		Bitmap membership(row_num_);
+		for (size_t row_idx: ScanFind(query, nullptr)) {
+			membership.Set(row_idx);
+		}
+		return membership;
+	}
+
+	// and/or are folded on bitmaps, leaves the indexes can't answer count as every row
+	// and make the result a superset that is filtered by a scan of its rows
+	struct Candidates {
+		Bitmap rows_;
+		bool exact_;
+	};
+	size_t indexed_leaves = 0;
+	Candidates candidates = query.Fold<Candidates>(
+		[&](std::string_view attr, SubsetQuery::Op op, std::string_view val) {
+			Candidates leaf = {Bitmap(), false};
+			auto col = column_idx_.find(string(attr));
+			auto index = col == column_idx_.end() ? bitmap_indexes_.end() : bitmap_indexes_.find(col->second);
+			if (index == bitmap_indexes_.end() || (op != SubsetQuery::kEq && op != SubsetQuery::kNe)) {
+				leaf.rows_.Flip(row_num_);
+				return leaf;
+			}
+			if (!UpdateBitmapIndex(col->second, &index->second)) {
+				// grew past its cardinality limit through appends
+				bitmap_indexes_.erase(index);
+				leaf.rows_.Flip(row_num_);
+				return leaf;
+			}
+			auto value = index->second.values_.find(string(val));
+			if (value != index->second.values_.end()) {
+				leaf.rows_ = value->second;
+			}
+			if (op == SubsetQuery::kNe) {
+				leaf.rows_.Flip(row_num_);
+			}
+			leaf.exact_ = true;
+			indexed_leaves++;
+			return leaf;
+		},
+		[](bool is_and, Candidates left, const Candidates& right) {
+			if (is_and) {
+				left.rows_.And(right.rows_);
+			} else {
+				left.rows_.Or(right.rows_);
+			}
+			left.exact_ = left.exact_ && right.exact_;
+			return left;
+		});
+
+	if (candidates.exact_) {
+		return candidates.rows_;
+	}
+	Bitmap membership;
+	for (size_t row_idx: ScanFind(query, indexed_leaves == 0 ? nullptr : &candidates.rows_)) {
+		membership.Set(row_idx);
+	}
+	return membership;
+}
+
+vector<size_t> MemoryTable::Find(const SubsetQuery& query) {
+	if (!bitmap_indexes_.empty()) {
+		vector<size_t> res;
+		FindMembership(query).ToVector(&res);
+		return res;
+	}
+	return ScanFind(query, nullptr);
+}
+
+vector<size_t> MemoryTable::ScanFind(const SubsetQuery& query, const Bitmap* candidates) {
+	vector<size_t> res;
+	vector<int32_t> columns = query.ResolveColumns(GetSchemaAttributes());
+	const vector<ZoneMap>& zones = GetZoneMaps();
+	for (size_t b = 0; b < zones.size(); b++) {
+		size_t begin = b * kBlockRows;
+		size_t end = std::min(row_num_, begin + kBlockRows);
+		SubsetQuery::Match match = query.Classify(columns,
+				[&](size_t col) -> const string& { return zones[b].min_[col]; },
+				[&](size_t col) -> const string& { return zones[b].max_[col]; });
+		if (match == SubsetQuery::Match::kNone) {
+			continue;
+		}
+		for (size_t row = begin; row < end; row++) {
+			if (candidates != nullptr && !candidates->Test(row)) {
+				continue;
+			}
+			if (match == SubsetQuery::Match::kAll ||
+					query.Satisfy(columns, [&](size_t col) -> const string& { return columns_[col][row]; })) {
+				res.push_back(row);
+			}
+		}
+	}
+	return res;
+}
+
+
+}  // dcr
@@ -0,0 +1,156 @@
+#ifndef DCR_IO_MEMORY_TABLE_H_
+#define DCR_IO_MEMORY_TABLE_H_
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include "core/table.h"
+#include "core/subset_query.h"
+
+namespace dcr {
+
+class Table;
+class SubsetQuery;
+
+// Column-major table held in process memory, rows are indexed from 0.
+class MemoryTable: public Table {
+public:
+    MemoryTable(const std::string& tablename, const std::vector<std::string>& attrs): row_num_(0) {
+        tablename_ = tablename;
+        attrs_ = attrs;
+        columns_.resize(attrs_.size());
+        for (size_t i = 0; i < attrs_.size(); i++) {
+            column_idx_[attrs_[i]] = i;
+        }
+    }
+
+    MemoryTable() = delete;
+
+    // values are in the order of GetSchemaAttributes()
+    void AppendRow(const std::vector<std::string>& values);
+
+    std::unique_ptr<TableIterator> GetIterator();
+
+    // contiguous row ranges
+    std::vector<std::unique_ptr<TableIterator>> GetPartitionedIterators();
+
+    std::vector<size_t> FindConflict(const RecordView& r);
+
+    std::vector<size_t> Find(const SubsetQuery&);
+
+    Record GetRecord(size_t row_idx);
+
+    // view of a row straight into the column storage, fields is the reused buffer
+    RecordView GetRecordView(size_t row_idx, std::vector<std::string_view>* fields) const {
+        fields->resize(attrs_.size());
+        for (size_t i = 0; i < attrs_.size(); i++) {
+            (*fields)[i] = columns_[SchemaColumn(i)][row_idx];
+        }
+        return RecordView(row_idx, fields->data(), &attrs_);
+    }
+
+    // appends rows [begin, end) to batch as views into the column storage
+    void FillBatch(size_t begin, size_t end, RowBatch* batch) const {
+        batch->Clear(&attrs_);
+        for (size_t row = begin; row < end; row++) {
+            batch->AddRow(row);
+            for (size_t i = 0; i < attrs_.size(); i++) {
+                batch->AddField(columns_[SchemaColumn(i)][row]);
+            }
+        }
+    }
+
+    size_t GetTotalRowNum() {
+        return row_num_;
+    }
+
+    // rows per zone map block
+    static constexpr size_t kBlockRows = 1 << 16;
+
+    // Per block and column statistics, Find() skips blocks whose bounds rule the query out
+    // and takes blocks whose bounds imply it without looking at their rows.
+    struct ZoneMap {
+        std::vector<std::string> min_;
+        std::vector<std::string> max_;
+        std::vector<size_t> distinct_;
+    };
+
+    // zone maps of all blocks, the last one may be partial
+    const std::vector<ZoneMap>& GetZoneMaps();
+
+    // Indexes attr by one bitmap per distinct value, so = and != leaves of a query are
+    // answered with bitmap operations. Returns false and builds nothing if attr has more
+    // than max_distinct values, dense bitmaps only pay off on low cardinality columns.
+    bool CreateBitmapIndex(const std::string& attr, size_t max_distinct = 256);
+
+    Bitmap FindMembership(const SubsetQuery& query);
+
+private:
+    struct BitmapIndex {
+        std::unordered_map<std::string, Bitmap> values_;
+        size_t max_distinct_;
+        // rows covered, later appends are indexed on the next lookup
+        size_t indexed_row_num_ = 0;
+    };
+
+    void BuildConflictIndex();
+
+    // brings the index up to row_num_, false once it exceeds its cardinality limit
+    bool UpdateBitmapIndex(size_t col, BitmapIndex* index);
+
+    // rows satisfying the query, scanning only blocks the zone maps can't decide
+    std::vector<size_t> ScanFind(const SubsetQuery& query, const Bitmap* candidates);
+
+    void UpdateZoneMaps();
+
+    std::vector<std::vector<std::string>> columns_;
+    std::unordered_map<std::string, size_t> column_idx_;
+    size_t row_num_;
+
+    // per FD: concatenated LHS values -> rows, rebuilt when rows or FDs change
+    std::vector<std::unordered_map<std::string, std::vector<size_t>>> lhs_index_;
+    size_t indexed_row_num_ = 0;
+    size_t indexed_fd_num_ = 0;
+
+    std::vector<ZoneMap> zone_maps_;
+    // rows covered by zone_maps_, blocks past this point are recomputed on demand
+    size_t zoned_row_num_ = 0;
+
+    // column -> bitmap index
+    std::unordered_map<size_t, BitmapIndex> bitmap_indexes_;
+};
+
+
+class MemoryTableIterator: public TableIterator {
+public:
+    explicit MemoryTableIterator(MemoryTable* table): table_(table), pos_(0), end_(table->GetTotalRowNum()) {}
+
+    // rows [begin, end)
+    MemoryTableIterator(MemoryTable* table, size_t begin, size_t end): table_(table), pos_(begin), end_(end) {}
+
+    bool HasNext() {
+        return pos_ < end_;
+    }
+
+    RecordView NextView() {
+        return table_->GetRecordView(pos_++, &fields_);
+    }
+
+    size_t NextBatch(RowBatch* batch, size_t max_rows) {
+        size_t end = std::min(end_, pos_ + max_rows);
+        table_->FillBatch(pos_, end, batch);
+        pos_ = end;
+        return batch->Size();
+    }
+
+private:
+    MemoryTable* table_;
+    size_t pos_;
+    size_t end_;
+    std::vector<std::string_view> fields_;
+};
+
+}  // dcr
+#endif  // DCR_IO_MEMORY_TABLE_H_
@@ -1,75 +1,378 @@
 #include "io/sqlite_table.h"
+#include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <stdio.h>
 #include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "core/parallel.h"
 #include "core/table.h"
 
 
 namespace dcr {
+using std::pair;
 using std::string;
 using std::unordered_map;
+using std::unordered_set;
 using std::vector;
 
+// readers map the database file so parallel scans share the OS page cache, unless the
+// profile sets its own mmap size
+static const int64_t kReaderMmapBytes = (int64_t)1 << 30;
 
-static int FindConflictCallback(void* data, int argc, char** argv, char** azColName) {
-	unordered_map<size_t>* pMap = static_cast<unordered_map<size_t>>(data);
-	int ret = atoi(argv[0]);
-	pMap->insert(ret);
-	return 0;
+// GetRowIndexBound() accepts rowids below kMaxRowidSpread times the row count plus
+// kRowidSlack, gaps from deletes stay well within that
+static const size_t kMaxRowidSpread = 16;
+static const size_t kRowidSlack = 1 << 20;
+
+SqliteTable::SqliteTable(string filename, string tablename, int file_type, const SqliteIoProfile& profile):
+		filename_(filename), file_type_(file_type), profile_(profile), db_(NULL) {
+	tablename_ = tablename;
+	// the destructor does not run for a throwing constructor
+	try {
+		Open();
+	} catch (...) {
+		sqlite3_close(db_);
+		throw;
+	}
+}
+
+void SqliteTable::Open() {
+	if (file_type_ == 0) {  // sqlite database
+		if (sqlite3_open(filename_.c_str(), &db_) != SQLITE_OK) {
+			throw "Can't open database file!";
+		}
+		if (profile_.backup_to_memory_) {
+			BackupToMemory();
+		}
+	} else {
+		if (sqlite3_open(":memory:", &db_) != SQLITE_OK) {
+			throw "Can't open memory database!";
+		}
+
+		sqlite3_enable_load_extension(db_, 1);
+
+		const char* zFile = "csv.so";
+		char* msg = NULL;
+		sqlite3_load_extension(db_, zFile, NULL, &msg);
+		sqlite3_free(msg);
+
+		string create_table = "CREATE VIRTUAL TABLE " + tablename_ + " USING csv(filename=" + filename_ + ")";
+		if (sqlite3_exec(db_, create_table.c_str(), NULL, NULL, NULL)) {
+			throw "Create virtual table failed!";
+		}
+	}
+	ApplyProfile(db_, true);
+
+	string sql = "select * from " + tablename_;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db_, sql.c_str(), sql.size(), &stmt, NULL) != SQLITE_OK) {
+		throw "Can't parse table query!";
+	}
+	for (int i = 0; i < sqlite3_column_count(stmt); i++) {
+		attrs_.push_back(string(sqlite3_column_name(stmt, i)));
+	}
+	sqlite3_finalize(stmt);
+}
+
+static sqlite3_int64 PragmaInt(sqlite3* db, const string& pragma) {
+	sqlite3_stmt* stmt;
+	sqlite3_int64 val = 0;
+	if (sqlite3_prepare_v2(db, pragma.c_str(), pragma.size(), &stmt, NULL) == SQLITE_OK) {
+		if (sqlite3_step(stmt) == SQLITE_ROW) {
+			val = sqlite3_column_int64(stmt, 0);
+		}
+		sqlite3_finalize(stmt);
+	}
+	return val;
+}
+
+// asks the OS to prefetch the first bytes of path into its page cache, so the pages sqlite
+// reads next come from memory; best effort, errors are ignored
+static void ReadAhead(const string& path, int64_t bytes) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	posix_fadvise(fd, 0, bytes, POSIX_FADV_WILLNEED);
+	close(fd);
+}
+
+void SqliteTable::ApplyProfile(sqlite3* db, bool main_connection) {
+	int64_t page_size = PragmaInt(db, "pragma page_size");
+	if (page_size <= 0) {
+		page_size = 4096;
+	}
+	vector<string> pragmas;
+	int64_t mmap_size = profile_.mmap_size_ == 0 && !main_connection ? kReaderMmapBytes : profile_.mmap_size_;
+	if (mmap_size > 0) {
+		pragmas.push_back("pragma mmap_size = " + std::to_string((mmap_size + page_size - 1) / page_size * page_size));
+	}
+	if (profile_.cache_size_ > 0) {
+		// positive values count pages, so the cache holds whole pages of this database
+		pragmas.push_back("pragma cache_size = " + std::to_string(std::max<int64_t>(1, profile_.cache_size_ / page_size)));
+	}
+	if (profile_.temp_store_memory_) {
+		pragmas.push_back("pragma temp_store = memory");
+	}
+	if (main_connection && !profile_.journal_mode_.empty()) {
+		pragmas.push_back("pragma journal_mode = " + profile_.journal_mode_);
+	}
+	if (profile_.query_only_) {
+		pragmas.push_back("pragma query_only = 1");
+	}
+	// readers share the OS page cache with the main connection, and a backup copy is
+	// already in memory
+	if (main_connection && profile_.read_ahead_ > 0 && file_type_ == 0 && !profile_.backup_to_memory_) {
+		ReadAhead(filename_, (profile_.read_ahead_ + page_size - 1) / page_size * page_size);
+	}
+	for (const string& pragma: pragmas) {
+		if (sqlite3_exec(db, pragma.c_str(), NULL, NULL, NULL) != SQLITE_OK) {
+			throw "Fail to apply io profile!";
+		}
+	}
+}
+
+void SqliteTable::BackupToMemory() {
+	sqlite3* mem_db;
+	if (sqlite3_open(":memory:", &mem_db) != SQLITE_OK) {
+		sqlite3_close(mem_db);
+		throw "Can't open memory database!";
+	}
+	sqlite3_backup* backup = sqlite3_backup_init(mem_db, "main", db_, "main");
+	if (backup == NULL) {
+		sqlite3_close(mem_db);
+		throw "Fail to copy database into memory!";
+	}
+	sqlite3_backup_step(backup, -1);
+	int rc = sqlite3_backup_finish(backup);
+	if (rc != SQLITE_OK) {
+		sqlite3_close(mem_db);
+		throw "Fail to copy database into memory!";
+	}
+	sqlite3_close(db_);
+	db_ = mem_db;
+}
+
+
+std::unique_ptr<TableIterator> SqliteTable::GetIterator() {
+	return std::unique_ptr<TableIterator>(new SqliteTableIterator(db_, tablename_, &attrs_));
+}
+
+vector<pair<sqlite3_int64, sqlite3_int64>> SqliteTable::PartitionRowids() {
+	vector<pair<sqlite3_int64, sqlite3_int64>> ranges;
+	if (file_type_ != 0 || profile_.backup_to_memory_ || scan_threads_ <= 1) {
+		return ranges;
+	}
+
+	string sql = "select min(rowid), max(rowid) from " + tablename_;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db_, sql.c_str(), sql.size(), &stmt, NULL) != SQLITE_OK) {
+		throw "Fail to read rowid range!";
+	}
+	bool empty = sqlite3_step(stmt) != SQLITE_ROW || sqlite3_column_type(stmt, 0) == SQLITE_NULL;
+	sqlite3_int64 first = empty ? 0 : sqlite3_column_int64(stmt, 0);
+	sqlite3_int64 last = empty ? 0 : sqlite3_column_int64(stmt, 1);
+	sqlite3_finalize(stmt);
+	if (empty) {
+		return ranges;
+	}
+
+	while (readers_.size() < scan_threads_) {
+		Reader reader;
+		if (sqlite3_open_v2(filename_.c_str(), &reader.db_, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL)
+				!= SQLITE_OK) {
+			sqlite3_close(reader.db_);
+			throw "Can't open database file for parallel scan!";
+		}
+		readers_.push_back(reader);
+		ApplyProfile(reader.db_, false);
+	}
+
+	// split by rowid, balanced as long as rowids are dense
+	sqlite3_int64 span = last - first + 1;
+	size_t parts = std::min<sqlite3_int64>(scan_threads_, span);
+	for (size_t i = 0; i < parts; i++) {
+		ranges.emplace_back(first + span * i / parts, first + span * (i + 1) / parts - 1);
+	}
+	return ranges;
+}
+
+vector<std::unique_ptr<TableIterator>> SqliteTable::GetPartitionedIterators() {
+	vector<pair<sqlite3_int64, sqlite3_int64>> ranges = PartitionRowids();
+	if (ranges.empty()) {
+		return Table::GetPartitionedIterators();
+	}
+	vector<std::unique_ptr<TableIterator>> iters;
+	for (size_t i = 0; i < ranges.size(); i++) {
+		iters.emplace_back(new SqliteTableIterator(readers_[i].db_, tablename_, &attrs_, ranges[i].first,
+				ranges[i].second));
+	}
+	return iters;
+}
+
+Record SqliteTable::GetRecord(size_t row_idx) {
+	string sql = "select " + SqliteSelectList(attrs_) + " from " + tablename_ + " where rowid = ?";
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db_, sql.c_str(), sql.size(), &stmt, NULL) != SQLITE_OK) {
+		throw "Fail to get record!";
+	}
+	sqlite3_bind_int64(stmt, 1, (sqlite3_int64)row_idx);
+	unordered_map<string, string> content;
+	if (sqlite3_step(stmt) == SQLITE_ROW) {
+		for (size_t i = 0; i < attrs_.size(); i++) {
+			const unsigned char* val = sqlite3_column_text(stmt, i + 1);
+			content[attrs_[i]] = val == NULL ? string() : string((const char*)val);
+		}
+	}
+	sqlite3_finalize(stmt);
+	return Record(row_idx, content);
 }
 
-static int FindCallback(void* data, int argc, char** argv, char** azColName) {
-	vector<size_t>*pVec = static_cast<vector<size_t>>(data);
-	int ret = atoi(argv[0]);
-	pVec->push_back(ret);
-	return 0;
+size_t SqliteTable::GetTotalRowNum() {
+	string sql = "select count(*) from " + tablename_;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db_, sql.c_str(), sql.size(), &stmt, NULL) != SQLITE_OK) {
+		throw "Fail to count rows!";
+	}
+	size_t count = 0;
+	if (sqlite3_step(stmt) == SQLITE_ROW) {
+		count = (size_t)sqlite3_column_int64(stmt, 0);
+	}
+	sqlite3_finalize(stmt);
+	return count;
+}
+
+size_t SqliteTable::GetRowIndexBound() {
+	string sql = "select min(rowid), max(rowid), count(*) from " + tablename_;
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db_, sql.c_str(), sql.size(), &stmt, NULL) != SQLITE_OK) {
+		throw "Fail to read rowid range!";
+	}
+	if (sqlite3_step(stmt) != SQLITE_ROW || sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+		sqlite3_finalize(stmt);
+		return 0;
+	}
+	sqlite3_int64 first = sqlite3_column_int64(stmt, 0);
+	sqlite3_int64 last = sqlite3_column_int64(stmt, 1);
+	size_t count = (size_t)sqlite3_column_int64(stmt, 2);
+	sqlite3_finalize(stmt);
+	// everything sized by the bound is allocated per row index, a few far out rowids
+	// would make it huge
+	if (first < 0 || (size_t)last >= count * kMaxRowidSpread + kRowidSlack) {
+		throw "Rowids too sparse to index rows by them, copy the table to renumber its rows!";
+	}
+	return (size_t)last + 1;
 }
 
-vector<size_t> SqliteTable::FindConflict(const Record& r) {
-	unordered_map<size_t> res;
-	for (FunctionalDependency& fd: fds_) {
+vector<size_t> SqliteTable::FindConflict(const RecordView& r) {
+	unordered_set<size_t> res;
+	for (const FunctionalDependency& fd: fds_) {
+		// "lhs = ? and ... and (rhs != ? or ...)", the values of r bound in that order
+		vector<string> lhs_attrs = fd.GetLeftHandAttrs();
+		vector<string> rhs_attrs = fd.GetRightHandAttrs();
 		string sql = "select rowid from " + tablename_ + " where ";
-		int flag = 0;
-		for (string& attr: fd.GetLeftHandAttrs()) {
-			if (flag != 0) {
-				sql += "and ";
-			}
-			flag++;
-			sql += attr + " = " + r.GetField(attr) + " ";
+		for (const string& attr: lhs_attrs) {
+			sql += SqliteQuoteName(attr) + " = ? and ";
 		}
-		sql += "and (";
-		flag = 0;
-		for (string& attr: fd.GetRightHandAttrs()) {
-			of (flag != 0) {
-				sql += "or ";
-			}
-			sql += attr + " != " r.GetField(attr) + " ";
+		sql += "(";
+		for (size_t i = 0; i < rhs_attrs.size(); i++) {
+			sql += (i == 0 ? "" : " or ") + SqliteQuoteName(rhs_attrs[i]) + " != ?";
 		}
 		sql += ")";
 
-		if (sqlite3_exec(db_, sql.c_str(), FindConflictCallback, (void*)&res, NULL) != SQLITE_OK) {
+		sqlite3_stmt* stmt = PreparedFind(db_, &find_stmts_, sql);
+		int param = 1;
+		for (const vector<string>* attrs: {&lhs_attrs, &rhs_attrs}) {
+			for (const string& attr: *attrs) {
+				std::string_view val = r.GetField(attr);
+				sqlite3_bind_text(stmt, param++, val.data() == NULL ? "" : val.data(), val.size(), SQLITE_STATIC);
+			}
+		}
+		int rc;
+		while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+			res.insert((size_t)sqlite3_column_int64(stmt, 0));
+		}
+		sqlite3_reset(stmt);
+		sqlite3_clear_bindings(stmt);
+		if (rc != SQLITE_DONE) {
 			throw "Fail to find conflict!";
 		}
 	}
 
-	vector<size_t> tmp;
-	for (size_t v: res) {
-		tmp.push_back(v);
+	return vector<size_t>(res.begin(), res.end());
+}
+
+sqlite3_stmt* SqliteTable::PreparedFind(sqlite3* db, unordered_map<string, sqlite3_stmt*>* stmts,
+		const string& sql) {
+	auto iter = stmts->find(sql);
+	if (iter != stmts->end()) {
+		return iter->second;
+	}
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v3(db, sql.c_str(), sql.size(), SQLITE_PREPARE_PERSISTENT, &stmt, NULL) != SQLITE_OK) {
+		throw "Fail to prepare find!";
+	}
+	(*stmts)[sql] = stmt;
+	return stmt;
+}
+
+// binds literals from parameter first_param on, steps stmt to the end and resets it
+static void RunFind(sqlite3_stmt* stmt, const vector<std::string_view>& literals, int first_param,
+		vector<size_t>* res) {
+	for (size_t i = 0; i < literals.size(); i++) {
+		sqlite3_bind_text(stmt, first_param + i, literals[i].data(), literals[i].size(), SQLITE_STATIC);
+	}
+	int rc;
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+		res->push_back((size_t)sqlite3_column_int64(stmt, 0));
+	}
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	if (rc != SQLITE_DONE) {
+		throw "Fail to find!";
 	}
-	return tmp;
 }
 
-vector<size_t> Find(SubsetQuery& query) {
+vector<size_t> SqliteTable::Find(const SubsetQuery& query) {
 	vector<size_t> res;
+	vector<std::string_view> literals = query.Literals();
 
-	string sql = "select rowid from " + tablename_ + " where " + query.ToString();
-	if (sqlite3_exec(db_, sql.c_str(), FindCallback, (void*)&res, NULL) != SQLITE_OK) {
-		throw "Fail to find!";
+	vector<pair<sqlite3_int64, sqlite3_int64>> ranges = PartitionRowids();
+	if (ranges.empty()) {
+		string sql = "select rowid from " + tablename_ + " where " + query.Template();
+		RunFind(PreparedFind(db_, &find_stmts_, sql), literals, 1, &res);
+		return res;
 	}
 
+	string sql = "select rowid from " + tablename_ + " where rowid between ? and ? and (" + query.Template() + ")";
+	vector<vector<size_t>> parts(ranges.size());
+	ParallelFor(ranges.size(), [&](size_t i) {
+		sqlite3_stmt* stmt = PreparedFind(readers_[i].db_, &readers_[i].find_stmts_, sql);
+		sqlite3_bind_int64(stmt, 1, ranges[i].first);
+		sqlite3_bind_int64(stmt, 2, ranges[i].second);
+		RunFind(stmt, literals, 3, &parts[i]);
+	});
+	for (const vector<size_t>& part: parts) {
+		res.insert(res.end(), part.begin(), part.end());
+	}
 	return res;
 }
 
+uint64_t SqliteTable::GetVersion() {
+	sqlite3_stmt* stmt;
+	if (sqlite3_prepare_v2(db_, "pragma data_version", -1, &stmt, NULL) != SQLITE_OK) {
+		throw "Fail to read data version!";
+	}
+	uint64_t data_version = 0;
+	if (sqlite3_step(stmt) == SQLITE_ROW) {
+		data_version = (uint64_t)sqlite3_column_int64(stmt, 0);
+	}
+	sqlite3_finalize(stmt);
+	return (data_version << 32) ^ (uint64_t)sqlite3_total_changes(db_);
+}
+
 
 }  // dcr
\ No newline at end of file
@@ -1,8 +1,10 @@
 #ifndef DCR_IO_SQLITE_TABLE_H_
-#define DCR_CORE_SQLITE_TABLE_H_
+#define DCR_IO_SQLITE_TABLE_H_
 
-#include <stdio.h>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 #include "core/table.h"
@@ -13,110 +15,209 @@ namespace dcr {
 
 class Table;
 class SubsetQuery;
+class SqliteTableIterator;
+
+// attr as a quoted identifier
+inline std::string SqliteQuoteName(const std::string& attr) {
+    std::string name = "\"";
+    for (char c: attr) {
+        name += c;
+        if (c == '"') {
+            name += '"';
+        }
+    }
+    name += '"';
+    return name;
+}
+
+// "rowid, <attrs>" with quoted column names, so scans read the projected columns only
+inline std::string SqliteSelectList(const std::vector<std::string>& attrs) {
+    std::string list = "rowid";
+    for (const std::string& attr: attrs) {
+        list += ", " + SqliteQuoteName(attr);
+    }
+    return list;
+}
+
+// Connection settings for read-heavy analysis, every field left at its default keeps
+// SQLite's own setting.
+struct SqliteIoProfile {
+    // bytes of the database file memory mapped, rounded up to whole pages
+    int64_t mmap_size_ = 0;
+    // bytes of page cache, converted to pages of the database's page size
+    int64_t cache_size_ = 0;
+    bool temp_store_memory_ = false;
+    // bytes at the start of a database file the OS is asked to prefetch when it is opened,
+    // rounded up to whole pages
+    int64_t read_ahead_ = 0;
+    // "off", "wal", ... on the main connection, empty keeps the database's mode
+    std::string journal_mode_;
+    bool query_only_ = false;
+    // copy a database file into a private :memory: database before analysis through the
+    // backup API; parallel scans are not available on the copy
+    bool backup_to_memory_ = false;
+
+    // settings for analysing a database nobody writes to meanwhile
+    static SqliteIoProfile ReadOnlyAnalysis() {
+        SqliteIoProfile profile;
+        profile.mmap_size_ = (int64_t)1 << 30;
+        profile.cache_size_ = (int64_t)256 << 20;
+        profile.temp_store_memory_ = true;
+        profile.read_ahead_ = (int64_t)64 << 20;
+        profile.journal_mode_ = "off";
+        profile.query_only_ = true;
+        return profile;
+    }
+};
+
 
 class SqliteTable: public Table {
 public:
-    SqliteTable(std::string filename, std::string tablename, int file_type) {
-        tablename_ = tablename;
+    SqliteTable(std::string filename, std::string tablename, int file_type):
+            SqliteTable(filename, tablename, file_type, SqliteIoProfile()) {}
 
-        if (flag == 0) {  // sqlite database 
-            if (sqlite3_open(filename.c_str(), &db_) != SQLITE_OK) {
-                throw "Can't open database file!";
-            }
-        } else {
-            if (sqlite3_open(":memory:", &db_) != SQLITE_OK) {
-                throw "Can't open memory database!";
-            }
+    // file_type 0 opens a sqlite database, anything else a csv file through the csv extension
+    SqliteTable(std::string filename, std::string tablename, int file_type, const SqliteIoProfile& profile);
 
-            sqlite3_enable_load_extension(db_, 1);
-
-            const char* zFile = "csv.so";
-            char* msg;
-            sqlite3_load_extension(db_, zFile, NULL, &msg);
-            
-            char create_table[256];
-            sprintf(create_table, "CREATE VIRTUAL TABLE %s USING csv(filename=%s)", tablename_.c_str(), filename.c_str());
-            if (sqlite3_exec(db_, create_table, NULL, NULL, &msg)) {
-                throw "Create virtual table failed!";
-            }
-        }
+    std::vector<size_t> FindConflict(const RecordView& r);
 
-        std::string sql = "select * from " + tablename_;
+    std::vector<size_t> Find(const SubsetQuery&);
 
-        sqlite3_stmt* stmt;
-        int ret = sqlite3_prepare(db_, sql.c_str(), sql.size(), &stmt, NULL);
-        if (rc) {
-            fprintf(stderr, "Can't parse %s\n", sql.c_str());
-            exit(1);
-        }
+    Record GetRecord(size_t row_idx);
 
-        char *colname;
-        for (int i = 0;; i++) {
-            colname = sqlite3_column_name(stmt, 0);
-            if (colname == NULL) {
-                break;
-            }
-            attrs_.push_back(std::string(colname));
-        }
-    }
+    size_t GetTotalRowNum();
 
-    std::vector<size_t> FindConflict(const Record& r);
+    // max(rowid) + 1, throws for negative rowids or ones far beyond the row count
+    size_t GetRowIndexBound();
 
-    std::vector<size_t> Find(SubsetQuery&);
+    // data_version moves on commits by other connections, total_changes on our own
+    uint64_t GetVersion();
 
     SqliteTable() = delete;
 
     ~SqliteTable() {
+        for (auto& kv: find_stmts_) {
+            sqlite3_finalize(kv.second);
+        }
+        for (Reader& reader: readers_) {
+            for (auto& kv: reader.find_stmts_) {
+                sqlite3_finalize(kv.second);
+            }
+            sqlite3_close(reader.db_);
+        }
         sqlite3_close(db_);
     }
 
-    TableIterator GetIterator() {
-        return SqliteTableIterator();
-    }
-    
+    std::unique_ptr<TableIterator> GetIterator();
+
+    // Rowid ranges scanned over read-only connections of their own, only for database
+    // files: a csv virtual table lives in the private memory database of db_. The readers
+    // see committed data only and each may be used by one thread at a time.
+    std::vector<std::unique_ptr<TableIterator>> GetPartitionedIterators();
 
 private:
+    // a read-only, no-mutex connection of a parallel scan with its own statements
+    struct Reader {
+        sqlite3* db_;
+        std::unordered_map<std::string, sqlite3_stmt*> find_stmts_;
+    };
+
+    // prepared statement for sql, kept in stmts so queries differing only in the bound
+    // literals share one statement
+    static sqlite3_stmt* PreparedFind(sqlite3* db, std::unordered_map<std::string, sqlite3_stmt*>* stmts,
+            const std::string& sql);
+
+    // inclusive rowid ranges of a parallel scan, one per reader; empty for a serial scan
+    std::vector<std::pair<sqlite3_int64, sqlite3_int64>> PartitionRowids();
+
+    // opens db_ and reads the schema, db_ is left for the caller to close on failure
+    void Open();
+
+    // pragmas of profile_ on db, journal mode only on the main connection
+    void ApplyProfile(sqlite3* db, bool main_connection);
+
+    void BackupToMemory();
+
+    std::string filename_;
+    int file_type_;
+    SqliteIoProfile profile_;
     sqlite3* db_;
+    std::unordered_map<std::string, sqlite3_stmt*> find_stmts_;
+    std::vector<Reader> readers_;
 };
 
 
 class SqliteTableIterator: public TableIterator {
 public:
 
-    SqliteTableIterator(sqlite3* db, std::string& tablename) {
+    SqliteTableIterator(sqlite3* db, std::string& tablename, const std::vector<std::string>* attrs) {
         db_ = db;
-        std::string sql = "select rowid, * from " + tablename;
+        attrs_ = attrs;
+        fields_.resize(attrs_->size());
+        std::string sql = "select " + SqliteSelectList(*attrs_) + " from " + tablename;
 
         if (sqlite3_prepare(db_, sql.c_str(), sql.size(), &stmt_, 0) != SQLITE_OK) {
             throw "Fail to iterate over table!";
         }
     }
 
+    // rows with rowid in [first, last]
+    SqliteTableIterator(sqlite3* db, std::string& tablename, const std::vector<std::string>* attrs,
+            sqlite3_int64 first, sqlite3_int64 last) {
+        db_ = db;
+        attrs_ = attrs;
+        fields_.resize(attrs_->size());
+        std::string sql = "select " + SqliteSelectList(*attrs_) + " from " + tablename + " where rowid between ? and ?";
+
+        if (sqlite3_prepare_v2(db_, sql.c_str(), sql.size(), &stmt_, 0) != SQLITE_OK) {
+            throw "Fail to iterate over table!";
+        }
+        sqlite3_bind_int64(stmt_, 1, first);
+        sqlite3_bind_int64(stmt_, 2, last);
+    }
+
     bool HasNext() {
-        if (sqlite3_step(stmt_) != SQLITE_ROW) {
+        // a finished statement would restart on the next step
+        if (done_ || sqlite3_step(stmt_) != SQLITE_ROW) {
+            done_ = true;
             return false;
-        } 
+        }
         return true;
     }
 
-    Record Next() {
-        size_t row_idx;
-        std::unordered_map<std::string, std::string> content;
-        int ncols = sqlite3_column_count(stmt_);
-        row_idx = (size_t)sqlite3_column_int(stmt_, 0);
-        for (int i = 1; i < ncols; i++) {
-            char* attr = sqlite3_column_name(stmt_, i);
-            char* val = sqlite3_column_text(stmt_, i);
-            content[std::string(attr)] = std::string(val);
+    // fields point into the statement's row, valid until the next step
+    RecordView NextView() {
+        size_t row_idx = (size_t)sqlite3_column_int64(stmt_, 0);
+        for (size_t i = 0; i < fields_.size(); i++) {
+            const char* val = (const char*)sqlite3_column_text(stmt_, i + 1);
+            fields_[i] = val == NULL ? std::string_view() : std::string_view(val, sqlite3_column_bytes(stmt_, i + 1));
         }
-        
-        Record r(row_idx, content);
-        return r;
+        return RecordView(row_idx, fields_.data(), attrs_);
+    }
+
+    // values are copied into the batch, the statement row only lives until the next step
+    size_t NextBatch(RowBatch* batch, size_t max_rows) {
+        batch->Clear(attrs_);
+        while (batch->Size() < max_rows && HasNext()) {
+            batch->AddRow((size_t)sqlite3_column_int64(stmt_, 0));
+            for (size_t i = 0; i < attrs_->size(); i++) {
+                const char* val = (const char*)sqlite3_column_text(stmt_, i + 1);
+                batch->CopyField(val, val == NULL ? 0 : sqlite3_column_bytes(stmt_, i + 1));
+            }
+        }
+        return batch->Size();
+    }
+
+    ~SqliteTableIterator() {
+        sqlite3_finalize(stmt_);
     }
 
 private:
     sqlite3* db_;
     sqlite3_stmt* stmt_;
+    bool done_ = false;
+    const std::vector<std::string>* attrs_;
+    std::vector<std::string_view> fields_;
 };
 
 }  // dcr
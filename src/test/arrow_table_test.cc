@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+#include "io/arrow_table.h"
+#include "io/memory_table.h"
+#include "test/test_util.h"
+
+namespace dcr {
+
+using std::string;
+using std::vector;
+
+// the same rows in a MemoryTable and an Arrow IPC file
+TEST(ArrowTableTest, FindConflictMatchesMemory) {
+    vector<string> attrs = {"a", "b", "d"};
+    MemoryTable memory("t", attrs);
+    vector<arrow::StringBuilder> builders(attrs.size());
+    std::mt19937 gen(1);
+    for (size_t row = 0; row < 1000; row++) {
+        vector<string> values = {std::to_string(gen() % 150), std::to_string(gen() % 3), std::to_string(gen() % 2)};
+        memory.AppendRow(values);
+        for (size_t i = 0; i < values.size(); i++) {
+            ASSERT_TRUE(builders[i].Append(values[i]).ok());
+        }
+    }
+    arrow::FieldVector fields;
+    vector<std::shared_ptr<arrow::Array>> columns(attrs.size());
+    for (size_t i = 0; i < attrs.size(); i++) {
+        fields.push_back(arrow::field(attrs[i], arrow::utf8()));
+        ASSERT_TRUE(builders[i].Finish(&columns[i]).ok());
+    }
+    std::shared_ptr<arrow::Schema> schema = arrow::schema(fields);
+    std::shared_ptr<arrow::Table> data = arrow::Table::Make(schema, columns);
+
+    string filename = ::testing::TempDir() + "dcr_find_conflict.arrow";
+    {
+        auto sink = arrow::io::FileOutputStream::Open(filename);
+        ASSERT_TRUE(sink.ok());
+        auto writer = arrow::ipc::MakeFileWriter(*sink, schema);
+        ASSERT_TRUE(writer.ok());
+        ASSERT_TRUE((*writer)->WriteTable(*data).ok());
+        ASSERT_TRUE((*writer)->Close().ok());
+        ASSERT_TRUE((*sink)->Close().ok());
+    }
+
+    vector<FunctionalDependency> fds = {FunctionalDependency::FromString("a -> b"),
+            FunctionalDependency::FromString("a, b -> d")};
+    memory.LoadFunctionalDependencies(fds);
+    ArrowTable arrow_table(filename, "t");
+    arrow_table.LoadFunctionalDependencies(fds);
+    EXPECT_EQ(ConflictGraph(arrow_table), ConflictGraph(memory));
+    std::remove(filename.c_str());
+}
+
+}  // dcr
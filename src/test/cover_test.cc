@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "core/cover_kernel.h"
+#include "core/exact_cover.h"
+#include "core/graph.h"
+#include "io/memory_table.h"
+#include "test/test_util.h"
+
+namespace dcr {
+
+using std::vector;
+
+// reducing, solving the rest optimally and lifting gives an optimum of the input
+TEST(VertexCoverKernelTest, LiftKeepsOptimality) {
+    std::mt19937 gen(7);
+    for (int round = 0; round < 300; round++) {
+        size_t n = 3 + gen() % 12;
+        double p = 0.1 + 0.1 * (gen() % 6);
+        AdjacencyList adj = RandomGraph(n, p, &gen);
+        vector<double> weights = RandomWeights(n, 4, &gen);
+        const vector<double>* w = round % 2 == 0 ? nullptr : &weights;
+
+        AdjacencyList reduced = adj;
+        VertexCoverKernel kernel(&reduced, w);
+        kernel.Reduce();
+        vector<size_t> lifted = kernel.Lift(BruteForceCover(reduced, w));
+        ASSERT_TRUE(IsCover(adj, lifted)) << "round " << round;
+        EXPECT_EQ(CoverWeight(lifted, w), CoverWeight(BruteForceCover(adj, w), w)) << "round " << round;
+    }
+}
+
+TEST(VertexCoverKernelTest, SolvesForests) {
+    std::mt19937 gen(11);
+    AdjacencyList adj(12);
+    for (size_t v = 1; v < adj.size(); v++) {
+        size_t u = gen() % v;
+        adj[u].push_back(v);
+        adj[v].push_back(u);
+    }
+    for (auto& list: adj) {
+        std::sort(list.begin(), list.end());
+    }
+    AdjacencyList reduced = adj;
+    VertexCoverKernel kernel(&reduced, nullptr);
+    kernel.Reduce();
+    EXPECT_EQ(kernel.GetRemovedNum(), adj.size());
+    vector<size_t> cover = kernel.Lift(vector<size_t>());
+    EXPECT_TRUE(IsCover(adj, cover));
+    EXPECT_EQ(cover.size(), BruteForceCover(adj, nullptr).size());
+}
+
+TEST(ExactVertexCoverTest, BranchAndReduceIsOptimal) {
+    std::mt19937 gen(3);
+    for (int round = 0; round < 200; round++) {
+        size_t n = 2 + gen() % 13;
+        AdjacencyList adj = RandomGraph(n, 0.1 + 0.1 * (gen() % 7), &gen, true);
+        vector<double> weights = RandomWeights(n, 5, &gen);
+        const vector<double>* w = round % 2 == 0 ? nullptr : &weights;
+
+        ExactVertexCover solver(adj, w);
+        double optimum = CoverWeight(BruteForceCover(adj, w), w);
+        vector<size_t> cover = solver.SolveBranchAndReduce();
+        ASSERT_TRUE(IsCover(adj, cover)) << "round " << round;
+        EXPECT_EQ(CoverWeight(cover, w), optimum) << "round " << round;
+
+        cover.clear();
+        if (solver.SolveClosedForm(&cover)) {
+            ASSERT_TRUE(IsCover(adj, cover)) << "round " << round;
+            EXPECT_EQ(CoverWeight(cover, w), optimum) << "round " << round;
+        }
+        cover.clear();
+        if (solver.SolveBipartite(&cover)) {
+            ASSERT_TRUE(IsCover(adj, cover)) << "round " << round;
+            EXPECT_EQ(CoverWeight(cover, w), optimum) << "round " << round;
+        }
+    }
+}
+
+TEST(ExactVertexCoverTest, ClosedFormShapes) {
+    std::mt19937 gen(5);
+    for (size_t n = 3; n <= 12; n++) {
+        AdjacencyList path(n), cycle(n), clique(n), star(n);
+        for (size_t v = 0; v < n; v++) {
+            if (v + 1 < n) {
+                path[v].push_back(v + 1);
+                path[v + 1].push_back(v);
+            }
+            cycle[v].push_back((v + 1) % n);
+            cycle[(v + 1) % n].push_back(v);
+            for (size_t u = 0; u < n; u++) {
+                if (u != v) {
+                    clique[v].push_back(u);
+                }
+            }
+            if (v > 0) {
+                star[0].push_back(v);
+                star[v].push_back(0);
+            }
+        }
+        for (auto& list: cycle) {
+            std::sort(list.begin(), list.end());
+        }
+        vector<double> weights = RandomWeights(n, 5, &gen);
+        for (const AdjacencyList* adj: {&path, &cycle, &clique, &star}) {
+            for (const vector<double>* w: {(const vector<double>*)nullptr, (const vector<double>*)&weights}) {
+                vector<size_t> cover;
+                ASSERT_TRUE(ExactVertexCover(*adj, w).SolveClosedForm(&cover)) << "n " << n;
+                ASSERT_TRUE(IsCover(*adj, cover)) << "n " << n;
+                EXPECT_EQ(CoverWeight(cover, w), CoverWeight(BruteForceCover(*adj, w), w)) << "n " << n;
+            }
+        }
+    }
+}
+
+TEST(ExactVertexCoverTest, BipartiteIsOptimal) {
+    std::mt19937 gen(9);
+    for (int round = 0; round < 100; round++) {
+        size_t left = 1 + gen() % 7, n = left + 1 + gen() % 7;
+        AdjacencyList adj(n);
+        for (size_t u = 0; u < left; u++) {
+            for (size_t v = left; v < n; v++) {
+                // v - left == u % (n - left) keeps the component connected
+                if (gen() % 3 == 0 || v - left == u % (n - left) || u == 0) {
+                    adj[u].push_back(v);
+                    adj[v].push_back(u);
+                }
+            }
+        }
+        vector<double> weights = RandomWeights(n, 5, &gen);
+        const vector<double>* w = round % 2 == 0 ? nullptr : &weights;
+        vector<size_t> cover;
+        ASSERT_TRUE(ExactVertexCover(adj, w).SolveBipartite(&cover)) << "round " << round;
+        ASSERT_TRUE(IsCover(adj, cover)) << "round " << round;
+        EXPECT_EQ(CoverWeight(cover, w), CoverWeight(BruteForceCover(adj, w), w)) << "round " << round;
+    }
+}
+
+// small FD tables: a -> b with few groups, w is the repair cost
+static std::unique_ptr<MemoryTable> MakeSmallTable(size_t rows, std::mt19937* gen) {
+    std::unique_ptr<MemoryTable> table(new MemoryTable("t", {"a", "b", "w"}));
+    for (size_t row = 0; row < rows; row++) {
+        table->AppendRow({std::to_string((*gen)() % 3), std::to_string((*gen)() % 3),
+                std::to_string(1 + (*gen)() % 4)});
+    }
+    table->LoadFunctionalDependencies({FunctionalDependency::FromString("a -> b")});
+    return table;
+}
+
+static GraphOptions TestGraphOptions() {
+    GraphOptions options;
+    options.seed_ = 42;
+    options.verbose_ = false;
+    return options;
+}
+
+TEST(PrimalDualTest, WithinTwiceTheOptimum) {
+    std::mt19937 gen(13);
+    for (int round = 0; round < 50; round++) {
+        std::unique_ptr<MemoryTable> table = MakeSmallTable(6 + gen() % 10, &gen);
+        AdjacencyList adj = ConflictGraph(*table);
+        size_t optimum = BruteForceCover(adj, nullptr).size();
+
+        Graph graph(table.get(), TestGraphOptions());
+        vector<size_t> cover = graph.VertexCoverPrimalDual();
+        ASSERT_TRUE(IsCover(adj, cover)) << "round " << round;
+        EXPECT_LE(cover.size(), 2 * optimum) << "round " << round;
+
+        vector<size_t> sequential = graph.VertexCoverPrimalDualParallel(1);
+        ASSERT_TRUE(IsCover(adj, sequential)) << "round " << round;
+        EXPECT_LE(sequential.size(), 2 * optimum) << "round " << round;
+        for (size_t threads: {2, 4}) {
+            EXPECT_EQ(graph.VertexCoverPrimalDualParallel(threads), sequential) << "round " << round;
+        }
+    }
+}
+
+// the rounds must reproduce the same maximal matching on any number of workers
+TEST(PrimalDualTest, ParallelIndependentOfThreads) {
+    std::mt19937 gen(19);
+    MemoryTable table("t", {"a", "b"});
+    for (size_t row = 0; row < 5000; row++) {
+        table.AppendRow({std::to_string(gen() % 400), std::to_string(gen() % 4)});
+    }
+    table.LoadFunctionalDependencies({FunctionalDependency::FromString("a -> b")});
+    AdjacencyList adj = ConflictGraph(table);
+    Graph graph(&table, TestGraphOptions());
+    vector<size_t> sequential = graph.VertexCoverPrimalDualParallel(1);
+    ASSERT_TRUE(IsCover(adj, sequential));
+    // the endpoints of a matching
+    EXPECT_EQ(sequential.size() % 2, 0u);
+    for (size_t threads: {2, 3, 8, 64}) {
+        EXPECT_EQ(graph.VertexCoverPrimalDualParallel(threads), sequential) << threads << " threads";
+    }
+}
+
+TEST(PrimalDualTest, WeightedWithinTwiceTheOptimum) {
+    std::mt19937 gen(17);
+    for (int round = 0; round < 50; round++) {
+        std::unique_ptr<MemoryTable> table = MakeSmallTable(6 + gen() % 10, &gen);
+        AdjacencyList adj = ConflictGraph(*table);
+        vector<double> weights(table->GetTotalRowNum());
+        for (size_t row = 0; row < weights.size(); row++) {
+            weights[row] = std::stod(table->GetRecord(row).GetField("w"));
+        }
+        double optimum = CoverWeight(BruteForceCover(adj, &weights), &weights);
+
+        GraphOptions options = TestGraphOptions();
+        options.weight_attr_ = "w";
+        Graph graph(table.get(), options);
+        vector<size_t> cover = graph.VertexCoverPrimalDual();
+        ASSERT_TRUE(IsCover(adj, cover)) << "round " << round;
+        EXPECT_EQ(graph.GetCoverWeight(cover), CoverWeight(cover, &weights)) << "round " << round;
+        EXPECT_LE(CoverWeight(cover, &weights), 2 * optimum) << "round " << round;
+    }
+}
+
+// the weighted LCA samples a cover of at most twice the optimum weight, the estimate of
+// its weight fraction is off by at most epsilon
+TEST(PrimalDualTest, WeightedLcaWithinTwiceTheOptimum) {
+    std::mt19937 gen(23);
+    const double epsilon = 0.05;
+    for (int round = 0; round < 20; round++) {
+        std::unique_ptr<MemoryTable> table = MakeSmallTable(6 + gen() % 10, &gen);
+        AdjacencyList adj = ConflictGraph(*table);
+        vector<double> weights(table->GetTotalRowNum());
+        double total = 0.0;
+        for (size_t row = 0; row < weights.size(); row++) {
+            weights[row] = std::stod(table->GetRecord(row).GetField("w"));
+            total += weights[row];
+        }
+        double optimum = CoverWeight(BruteForceCover(adj, &weights), &weights);
+
+        GraphOptions options = TestGraphOptions();
+        options.weight_attr_ = "w";
+        Graph graph(table.get(), options);
+        srand(round + 1);
+        double degree = graph.InconsistencyDegree(epsilon, SubsetQuery(""));
+        EXPECT_GE(degree, optimum / total - epsilon) << "round " << round;
+        EXPECT_LE(degree, 2 * optimum / total + epsilon) << "round " << round;
+    }
+}
+
+}  // dcr
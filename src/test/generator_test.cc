@@ -0,0 +1,57 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gen/dirty_data_generator.h"
+#include "io/memory_table.h"
+#include "test/test_util.h"
+
+namespace dcr {
+
+using std::vector;
+
+static std::unique_ptr<MemoryTable> Generate(DirtyDataGenerator* gen) {
+    std::unique_ptr<MemoryTable> table(new MemoryTable("t", gen->GetAttributes()));
+    vector<std::string> values;
+    while (gen->HasNext()) {
+        gen->Next(&values);
+        table->AppendRow(values);
+    }
+    return table;
+}
+
+TEST(DirtyDataGeneratorTest, MinimumVertexCoverSizeMatchesGraph) {
+    for (uint64_t seed: {1, 2, 3}) {
+        GeneratorSpec spec;
+        spec.rows_ = 300;
+        spec.fds_ = {FunctionalDependency::FromString("a -> b")};
+        spec.violation_rate_ = 0.2;
+        spec.lhs_groups_ = 60;
+        spec.default_cardinality_ = 4;
+        spec.extra_attrs_ = {"e"};
+        spec.seed_ = seed;
+        DirtyDataGenerator gen(spec);
+        std::unique_ptr<MemoryTable> table = Generate(&gen);
+        table->LoadFunctionalDependencies(spec.fds_);
+
+        size_t expected = 0;
+        ASSERT_TRUE(gen.MinimumVertexCoverSize(&expected));
+        EXPECT_GT(expected, 0u);
+        size_t actual = 0;
+        for (const AdjacencyList& component: Components(ConflictGraph(*table))) {
+            actual += BruteForceCover(component, nullptr).size();
+        }
+        EXPECT_EQ(actual, expected) << "seed " << seed;
+    }
+}
+
+TEST(DirtyDataGeneratorTest, NoGroundTruthForSeveralFds) {
+    GeneratorSpec spec;
+    spec.rows_ = 10;
+    spec.fds_ = {FunctionalDependency::FromString("a -> b"), FunctionalDependency::FromString("c -> d")};
+    DirtyDataGenerator gen(spec);
+    size_t size = 0;
+    EXPECT_FALSE(gen.MinimumVertexCoverSize(&size));
+}
+
+}  // dcr
@@ -0,0 +1,226 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <sqlite3.h>
+#include "core/graph.h"
+#include "core/oracle.h"
+#include "io/memory_table.h"
+#include "io/sqlite_table.h"
+
+namespace dcr {
+
+using std::string;
+using std::vector;
+
+TEST(OracleTest, CumulativeWeightsPastTheEnd) {
+    Bitmap members;
+    members.Set(1);
+    members.Set(3);
+    members.Set(9);
+    Oracle oracle(members);
+    EXPECT_EQ(oracle.CumulativeWeights({0.0, 2.0, 0.0, 0.5}), (vector<double>{2.0, 2.5, 3.5}));
+}
+
+// a -> b partitions of 60 rows, overlapped by c -> b partitions of 6 rows
+static std::unique_ptr<MemoryTable> MakeOverlappingTable() {
+    std::unique_ptr<MemoryTable> table(new MemoryTable("t", {"a", "b", "c"}));
+    for (size_t i = 0; i < 300; i++) {
+        table->AppendRow({std::to_string(i % 5), std::to_string(i * 7 % 3), std::to_string(i % 50)});
+    }
+    table->LoadFunctionalDependencies({FunctionalDependency::FromString("a -> b"),
+            FunctionalDependency::FromString("c -> b")});
+    return table;
+}
+
+// InconsistencyDegree of the fully materialized graph and of one built with options, under
+// the same keyed ranking and samples
+static void ExpectSameDegrees(Table* table, const GraphOptions& options) {
+    for (const char* query: {"", "a != 0", "c = 4 or c = 9"}) {
+        GraphOptions materialized;
+        materialized.seed_ = 3;
+        materialized.verbose_ = false;
+        materialized.ranking_mode_ = RankingMode::kKeyedHash;
+        const GraphOptions* both[] = {&materialized, &options};
+        double degrees[2];
+        for (size_t i = 0; i < 2; i++) {
+            Graph graph(table, *both[i]);
+            srand(1);
+            degrees[i] = graph.InconsistencyDegree(0.1, SubsetQuery(query));
+        }
+        EXPECT_GT(degrees[0], 0.0) << query;
+        EXPECT_EQ(degrees[0], degrees[1]) << query;
+    }
+}
+
+// the a -> b partitions become conflict groups, the c -> b ones stay pairwise edges
+TEST(ConflictGroupTest, MatchesMaterializedGraph) {
+    std::unique_ptr<MemoryTable> table = MakeOverlappingTable();
+    GraphOptions options;
+    options.seed_ = 3;
+    options.verbose_ = false;
+    options.group_threshold_ = 20;
+    // evict orders during the LCA recursion as well
+    options.group_cache_capacity_ = 8;
+    ExpectSameDegrees(table.get(), options);
+}
+
+TEST(ImplicitGraphTest, MatchesMaterializedGraph) {
+    std::unique_ptr<MemoryTable> table = MakeOverlappingTable();
+    GraphOptions options;
+    options.seed_ = 3;
+    options.verbose_ = false;
+    options.implicit_ = true;
+    options.neighbour_cache_capacity_ = 8;
+    ExpectSameDegrees(table.get(), options);
+}
+
+// a batch samples its distinct subgraphs in query order from the same rand() stream as
+// the single queries run one after another
+TEST(BatchTest, MatchesSingleQueries) {
+    std::unique_ptr<MemoryTable> table = MakeOverlappingTable();
+    vector<SubsetQuery> queries = {SubsetQuery("a != 0"), SubsetQuery("c = 4 or c = 9"), SubsetQuery("b = 7"),
+            SubsetQuery(""), SubsetQuery("a = 0 or a != 0")};
+    GraphOptions options;
+    options.seed_ = 3;
+    options.verbose_ = false;
+    Graph graph(table.get(), options);
+    srand(1);
+    vector<double> batch = graph.InconsistencyDegreeBatch(0.1, queries);
+    ASSERT_EQ(batch.size(), queries.size());
+    srand(1);
+    // the last query selects every row like the empty one and shares its estimate
+    for (size_t i = 0; i + 1 < queries.size(); i++) {
+        EXPECT_EQ(batch[i], graph.InconsistencyDegree(0.1, queries[i])) << queries[i].ToString();
+    }
+    EXPECT_EQ(batch.back(), batch[3]);
+    EXPECT_THROW(graph.InconsistencyDegree(0.1, SubsetQuery("zip = 1")), const char*);
+}
+
+// the matching the LCA simulates is the one VertexCoverPrimalDualParallel computes, so
+// its cover gives the exact degree of the whole table
+TEST(AdaptiveTest, IntervalContainsTheExactDegree) {
+    std::unique_ptr<MemoryTable> table = MakeOverlappingTable();
+    GraphOptions options;
+    options.seed_ = 3;
+    options.verbose_ = false;
+    Graph graph(table.get(), options);
+    double exact = (double)graph.VertexCoverPrimalDualParallel(1).size() / (double)graph.GetNodeNum();
+    for (unsigned int seed = 1; seed <= 5; seed++) {
+        srand(seed);
+        InconsistencyEstimate estimate = graph.InconsistencyDegreeAdaptive(0.05, 0.01, SubsetQuery(""));
+        EXPECT_LE(estimate.lower_, exact) << "seed " << seed;
+        EXPECT_GE(estimate.upper_, exact) << "seed " << seed;
+        EXPECT_LE(estimate.upper_ - estimate.estimate_, 0.05) << "seed " << seed;
+    }
+    for (double bad: {0.0, -0.1, 1.5}) {
+        EXPECT_THROW(graph.InconsistencyDegreeAdaptive(bad, 0.01, SubsetQuery("")), const char*);
+        EXPECT_THROW(graph.InconsistencyDegreeAdaptive(0.05, bad, SubsetQuery("")), const char*);
+    }
+}
+
+// 2 rows in 100 conflict, the variance is small enough to stop well before 8 / epsilon^2
+TEST(AdaptiveTest, StopsEarlyOnLowVariance) {
+    MemoryTable table("t", {"a", "b"});
+    for (size_t i = 0; i < 1000; i++) {
+        table.AppendRow({i % 100 < 2 ? "x" : std::to_string(i), std::to_string(i % 2)});
+    }
+    table.LoadFunctionalDependencies({FunctionalDependency::FromString("a -> b")});
+    GraphOptions options;
+    options.seed_ = 3;
+    options.verbose_ = false;
+    Graph graph(&table, options);
+    srand(1);
+    InconsistencyEstimate estimate = graph.InconsistencyDegreeAdaptive(0.05, 0.01, SubsetQuery(""));
+    EXPECT_LT(estimate.samples_, 8 / (0.05 * 0.05));
+    EXPECT_LE(estimate.upper_ - estimate.lower_, 2 * 0.05);
+}
+
+// rows without conflicts until edges are inserted
+TEST(InsertEdgeTest, ChangesTheEstimate) {
+    MemoryTable table("t", {"a", "b"});
+    for (size_t i = 0; i < 10; i++) {
+        table.AppendRow({std::to_string(i), "0"});
+    }
+    table.LoadFunctionalDependencies({FunctionalDependency::FromString("a -> b")});
+    GraphOptions options;
+    options.seed_ = 3;
+    options.verbose_ = false;
+    Graph graph(&table, options);
+    srand(1);
+    EXPECT_EQ(graph.InconsistencyDegree(0.1, SubsetQuery("")), 0.0);
+
+    graph.InsertEdge(2, 5);
+    graph.InsertEdge(5, 2);
+    EXPECT_EQ(graph.GetEdgeNum(), 1u);
+    EXPECT_THROW(graph.InsertEdge(3, 3), const char*);
+    srand(1);
+    // both endpoints of the only edge are in the cover
+    EXPECT_NEAR(graph.InconsistencyDegree(0.1, SubsetQuery("")), 0.2, 0.1);
+    srand(1);
+    EXPECT_EQ(graph.InconsistencyDegree(0.1, SubsetQuery("a = 2 or a = 5")), 1.0);
+
+    options.implicit_ = true;
+    Graph implicit(&table, options);
+    EXPECT_THROW(implicit.InsertEdge(2, 5), const char*);
+    options.implicit_ = false;
+    options.group_threshold_ = 2;
+    table.AppendRow({"0", "1"});
+    Graph grouped(&table, options);
+    EXPECT_THROW(grouped.InsertEdge(2, 5), const char*);
+}
+
+// rowids 1, 4, 7, ...: the first half of the rows is clean and weighs 0, the second
+// half shares one LHS value with alternating RHS values and weighs 1
+class SparseRowidTest: public ::testing::Test {
+protected:
+    SparseRowidTest() {
+        filename_ = ::testing::TempDir() + "dcr_sparse_rowids.db";
+        std::remove(filename_.c_str());
+        sqlite3* db;
+        sqlite3_open(filename_.c_str(), &db);
+        sqlite3_exec(db, "create table t(a, b, w); begin", NULL, NULL, NULL);
+        sqlite3_stmt* stmt;
+        sqlite3_prepare_v2(db, "insert into t(rowid, a, b, w) values (?, ?, ?, ?)", -1, &stmt, NULL);
+        for (size_t i = 0; i < kRows; i++) {
+            bool clean = i < kRows / 2;
+            string a = clean ? "x" + std::to_string(i) : "g";
+            sqlite3_bind_int64(stmt, 1, i * 3 + 1);
+            sqlite3_bind_text(stmt, 2, a.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 3, std::to_string(i % 2).c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 4, clean ? "0" : "1", -1, SQLITE_STATIC);
+            sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_exec(db, "commit", NULL, NULL, NULL);
+        sqlite3_close(db);
+    }
+
+    ~SparseRowidTest() {
+        std::remove(filename_.c_str());
+    }
+
+    static constexpr size_t kRows = 100;
+    string filename_;
+};
+
+TEST_F(SparseRowidTest, WeightsKeyedByRowid) {
+    SqliteTable table(filename_, "t", 0);
+    table.LoadFunctionalDependencies({FunctionalDependency::FromString("a -> b")});
+    for (bool implicit: {false, true}) {
+        GraphOptions options;
+        options.seed_ = 5;
+        options.verbose_ = false;
+        options.weight_attr_ = "w";
+        options.implicit_ = implicit;
+        Graph graph(&table, options);
+        // only the conflicting rows carry weight and every one of them is in the cover
+        srand(1);
+        EXPECT_EQ(graph.InconsistencyDegree(0.1, SubsetQuery("")), 1.0) << "implicit " << implicit;
+        EXPECT_EQ(graph.GetCoverWeight({1, kRows / 2 * 3 + 1, (kRows - 1) * 3 + 1}), 2.0) << "implicit " << implicit;
+    }
+}
+
+}  // dcr
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <sqlite3.h>
+#include "core/oracle.h"
+#include "core/query_cache.h"
+#include "core/subset_query.h"
+#include "io/memory_table.h"
+#include "io/sqlite_table.h"
+
+namespace dcr {
+
+using std::string;
+using std::vector;
+
+static const vector<vector<string>> kRows = {
+    {"CA", "O'Brien", "a and (b)"},
+    {"NY", "Smith", "c"},
+    {"CA", "Lee", "d"},
+    {"'CA'", "Kim", "e"},
+};
+
+static std::unique_ptr<MemoryTable> MakeStateTable() {
+    std::unique_ptr<MemoryTable> table(new MemoryTable("t", {"state", "name", "note"}));
+    for (const vector<string>& row: kRows) {
+        table->AppendRow(row);
+    }
+    return table;
+}
+
+static vector<size_t> Sorted(vector<size_t> rows) {
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+TEST(SubsetQueryTest, QuotedLiterals) {
+    SubsetQuery query("state = 'CA' and name != \"Lee\"");
+    vector<std::string_view> literals = query.Literals();
+    ASSERT_EQ(literals.size(), 2u);
+    EXPECT_EQ(literals[0], "CA");
+    EXPECT_EQ(literals[1], "Lee");
+    EXPECT_EQ(query.NormalizedText(), SubsetQuery("state = CA and name != Lee").NormalizedText());
+
+    EXPECT_EQ(SubsetQuery("name = 'O''Brien'").Literals()[0], "O'Brien");
+    EXPECT_EQ(SubsetQuery("state = '''CA'''").Literals()[0], "'CA'");
+    // and, or and parentheses inside quotes are part of the literal
+    SubsetQuery note("(note = 'a and (b)' or note = \"c\")");
+    EXPECT_EQ(note.Literals()[0], "a and (b)");
+    EXPECT_EQ(note.Literals()[1], "c");
+
+    EXPECT_THROW(SubsetQuery("state = 'CA"), InvalidExpressionException);
+    EXPECT_THROW(SubsetQuery("state = 'C'A'"), InvalidExpressionException);
+    EXPECT_THROW(SubsetQuery("state = 'CA''"), InvalidExpressionException);
+}
+
+TEST(SubsetQueryTest, QuotedLiteralsMatchOnBothBackends) {
+    string filename = ::testing::TempDir() + "dcr_quoted_literals.db";
+    std::remove(filename.c_str());
+    sqlite3* db;
+    ASSERT_EQ(sqlite3_open(filename.c_str(), &db), SQLITE_OK);
+    sqlite3_exec(db, "create table t(state, name, note)", NULL, NULL, NULL);
+    sqlite3_stmt* stmt;
+    sqlite3_prepare_v2(db, "insert into t(rowid, state, name, note) values (?, ?, ?, ?)", -1, &stmt, NULL);
+    for (size_t row = 0; row < kRows.size(); row++) {
+        sqlite3_bind_int64(stmt, 1, row);
+        for (size_t i = 0; i < kRows[row].size(); i++) {
+            sqlite3_bind_text(stmt, i + 2, kRows[row][i].c_str(), -1, SQLITE_TRANSIENT);
+        }
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+
+    std::unique_ptr<MemoryTable> memory = MakeStateTable();
+    SqliteTable sqlite(filename, "t", 0);
+    vector<std::pair<string, vector<size_t>>> cases = {
+        {"state = 'CA'", {0, 2}},
+        {"state = \"CA\" and name != 'Lee'", {0}},
+        {"name = 'O''Brien'", {0}},
+        {"state = '''CA'''", {3}},
+        {"note = 'a and (b)' or state = 'NY'", {0, 1}},
+    };
+    for (const auto& c: cases) {
+        SubsetQuery query(c.first);
+        EXPECT_EQ(Sorted(memory->Find(query)), c.second) << c.first;
+        EXPECT_EQ(Sorted(sqlite.Find(query)), c.second) << c.first;
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(OracleTest, BatchResolvesAgainstTheSchema) {
+    std::unique_ptr<MemoryTable> table = MakeStateTable();
+    table->SetProjection({"note", "state"});
+    vector<SubsetQuery> queries = {SubsetQuery("state = 'CA'"), SubsetQuery("name != 'Lee'"),
+            SubsetQuery("state = NY or name = Kim"), SubsetQuery("")};
+    vector<Oracle> oracles = Oracle::BuildBatch(*table, queries);
+    ASSERT_EQ(oracles.size(), queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        vector<size_t> expected = Sorted(table->Find(queries[i])), actual;
+        oracles[i].GetMembership().ToVector(&actual);
+        EXPECT_EQ(actual, expected) << queries[i].ToString();
+    }
+    EXPECT_EQ(oracles[1].NumberofNodesInSubgraph(), 3u);
+    EXPECT_THROW(Oracle::BuildBatch(*table, {SubsetQuery("zip = 1")}), const char*);
+    EXPECT_THROW(Oracle(*table, SubsetQuery("zip = 1")), const char*);
+}
+
+TEST(QueryCacheTest, TellsTablesApart) {
+    QueryCache cache;
+    SubsetQuery query("state = 'CA'");
+    std::unique_ptr<MemoryTable> first = MakeStateTable();
+    std::unique_ptr<MemoryTable> second(new MemoryTable("t", {"state", "name", "note"}));
+    for (size_t i = 0; i < kRows.size(); i++) {
+        second->AppendRow({"CA", "x", "y"});
+    }
+    // same name and version, different rows
+    ASSERT_EQ(first->GetVersion(), second->GetVersion());
+    EXPECT_EQ(cache.GetOracle(*first, query)->NumberofNodesInSubgraph(), 2u);
+    EXPECT_EQ(cache.GetOracle(*second, query)->NumberofNodesInSubgraph(), 4u);
+    EXPECT_EQ(cache.GetOracle(*first, query)->NumberofNodesInSubgraph(), 2u);
+    EXPECT_EQ(cache.GetHits(), 1u);
+
+    first->AppendRow({"CA", "z", "z"});
+    EXPECT_EQ(cache.GetOracle(*first, query)->NumberofNodesInSubgraph(), 3u);
+
+    // a table allocated where a destroyed one lived does not see its entries
+    second.reset();
+    second.reset(new MemoryTable("t", {"state", "name", "note"}));
+    for (size_t i = 0; i < kRows.size(); i++) {
+        second->AppendRow({"NY", "x", "y"});
+    }
+    EXPECT_EQ(cache.GetOracle(*second, query)->NumberofNodesInSubgraph(), 0u);
+}
+
+}  // dcr
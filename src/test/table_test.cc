@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <sqlite3.h>
+#include "core/oracle.h"
+#include "core/subset_query.h"
+#include "io/memory_table.h"
+#include "io/sqlite_table.h"
+#include "test/test_util.h"
+
+namespace dcr {
+
+using std::string;
+using std::vector;
+
+static string Padded(size_t i) {
+    string s = std::to_string(i);
+    return string(7 - s.size(), '0') + s;
+}
+
+// three zone map blocks over k = zero padded row index, v = row % 7
+class ZoneMapTest: public ::testing::Test {
+protected:
+    ZoneMapTest(): table_("t", {"k", "v"}) {
+        for (size_t row = 0; row < 2 * MemoryTable::kBlockRows + 100; row++) {
+            table_.AppendRow({Padded(row), std::to_string(row % 7)});
+        }
+    }
+
+    vector<size_t> BruteForceFind(const SubsetQuery& query) {
+        vector<size_t> rows;
+        vector<std::string_view> fields;
+        for (size_t row = 0; row < table_.GetTotalRowNum(); row++) {
+            if (query.Satisfy(table_.GetRecordView(row, &fields))) {
+                rows.push_back(row);
+            }
+        }
+        return rows;
+    }
+
+    MemoryTable table_;
+};
+
+TEST_F(ZoneMapTest, BlockBounds) {
+    const vector<MemoryTable::ZoneMap>& zones = table_.GetZoneMaps();
+    ASSERT_EQ(zones.size(), 3u);
+    for (size_t b = 0; b < zones.size(); b++) {
+        size_t last = std::min(table_.GetTotalRowNum(), (b + 1) * MemoryTable::kBlockRows) - 1;
+        EXPECT_EQ(zones[b].min_[0], Padded(b * MemoryTable::kBlockRows));
+        EXPECT_EQ(zones[b].max_[0], Padded(last));
+        EXPECT_EQ(zones[b].min_[1], "0");
+        EXPECT_EQ(zones[b].max_[1], "6");
+    }
+}
+
+TEST_F(ZoneMapTest, FindMatchesScan) {
+    for (string text: {"k < " + Padded(MemoryTable::kBlockRows),
+            "k >= " + Padded(MemoryTable::kBlockRows) + " and v = 3",
+            "k > " + Padded(100) + " and k <= " + Padded(2 * MemoryTable::kBlockRows + 5),
+            "v != 2 or k = " + Padded(7),
+            string("k > 9")}) {
+        SubsetQuery query(text);
+        vector<size_t> rows = table_.Find(query);
+        std::sort(rows.begin(), rows.end());
+        EXPECT_EQ(rows, BruteForceFind(query)) << text;
+    }
+}
+
+TEST(SubsetQueryTest, ClassifyRange) {
+    vector<string> attrs = {"k", "v"};
+    auto classify = [&](const string& text, const string& low, const string& high) {
+        SubsetQuery query(text);
+        return query.Classify(query.ResolveColumns(attrs),
+                [&](int32_t) { return std::string_view(low); }, [&](int32_t) { return std::string_view(high); });
+    };
+    EXPECT_EQ(classify("v = 3", "3", "3"), SubsetQuery::Match::kAll);
+    EXPECT_EQ(classify("v = 3", "4", "6"), SubsetQuery::Match::kNone);
+    EXPECT_EQ(classify("v = 3", "1", "6"), SubsetQuery::Match::kSome);
+    EXPECT_EQ(classify("v > 3", "4", "6"), SubsetQuery::Match::kAll);
+    EXPECT_EQ(classify("v < 3", "4", "6"), SubsetQuery::Match::kNone);
+    EXPECT_EQ(classify("v < 3 or v > 5", "6", "8"), SubsetQuery::Match::kAll);
+    EXPECT_EQ(classify("v >= 3 and v <= 5", "6", "8"), SubsetQuery::Match::kNone);
+}
+
+// oracles of v (7 values, indexed) and k (one value per row, over max_distinct) leaves,
+// before and after CreateBitmapIndex and after appends push v past its limit
+TEST_F(ZoneMapTest, BitmapIndexParity) {
+    vector<string> texts = {"v = 3", "v != 2", "v = 9", "v = 1 or v = 4", "v != 0 and v != 6",
+            "(v = 1 or v = 2) and v != 2", "v = 3 and k < " + Padded(MemoryTable::kBlockRows),
+            "v != 5 or k = " + Padded(7), "k = " + Padded(11), "k != " + Padded(11) + " and v = 0"};
+    vector<vector<size_t>> expected;
+    for (const string& text: texts) {
+        vector<size_t> rows;
+        Oracle(table_, SubsetQuery(text)).GetMembership().ToVector(&rows);
+        EXPECT_EQ(rows, BruteForceFind(SubsetQuery(text))) << text;
+        expected.push_back(rows);
+    }
+    EXPECT_TRUE(table_.CreateBitmapIndex("v", 7));
+    EXPECT_FALSE(table_.CreateBitmapIndex("k", 7));
+    for (size_t i = 0; i < texts.size(); i++) {
+        vector<size_t> rows;
+        Oracle(table_, SubsetQuery(texts[i])).GetMembership().ToVector(&rows);
+        EXPECT_EQ(rows, expected[i]) << texts[i];
+    }
+    table_.AppendRow({Padded(table_.GetTotalRowNum()), "7"});
+    for (const string& text: texts) {
+        vector<size_t> rows;
+        Oracle(table_, SubsetQuery(text)).GetMembership().ToVector(&rows);
+        EXPECT_EQ(rows, BruteForceFind(SubsetQuery(text))) << text << " after append";
+    }
+}
+
+// the same rows in a MemoryTable and a SQLite file, rowid = row index
+class FindConflictParityTest: public ::testing::Test {
+protected:
+    FindConflictParityTest(): memory_("t", {"a", "b c", "d"}) {
+        filename_ = ::testing::TempDir() + "dcr_find_conflict.db";
+        std::remove(filename_.c_str());
+        sqlite3* db;
+        sqlite3_open(filename_.c_str(), &db);
+        sqlite3_exec(db, "create table t(a, \"b c\", d); begin", NULL, NULL, NULL);
+        sqlite3_stmt* stmt;
+        sqlite3_prepare_v2(db, "insert into t(rowid, a, \"b c\", d) values (?, ?, ?, ?)", -1, &stmt, NULL);
+        std::mt19937 gen(1);
+        for (size_t row = 0; row < 1000; row++) {
+            // quotes in values must not break the SQLite lookup
+            vector<string> values = {std::to_string(gen() % 150) + (gen() % 5 == 0 ? "'x" : ""),
+                    std::to_string(gen() % 3), std::to_string(gen() % 2)};
+            memory_.AppendRow(values);
+            sqlite3_bind_int64(stmt, 1, row);
+            for (size_t i = 0; i < values.size(); i++) {
+                sqlite3_bind_text(stmt, i + 2, values[i].c_str(), -1, SQLITE_TRANSIENT);
+            }
+            sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_exec(db, "commit", NULL, NULL, NULL);
+        sqlite3_close(db);
+    }
+
+    ~FindConflictParityTest() {
+        std::remove(filename_.c_str());
+    }
+
+    string filename_;
+    MemoryTable memory_;
+};
+
+TEST_F(FindConflictParityTest, SqliteMatchesMemory) {
+    vector<FunctionalDependency> fds = {FunctionalDependency::FromString("a -> b c"),
+            FunctionalDependency::FromString("a, b c -> d")};
+    memory_.LoadFunctionalDependencies(fds);
+    SqliteTable sqlite(filename_, "t", 0);
+    sqlite.LoadFunctionalDependencies(fds);
+
+    size_t conflicts = 0;
+    auto it = memory_.GetIterator();
+    while (it->HasNext()) {
+        RecordView r = it->NextView();
+        vector<size_t> expected = memory_.FindConflict(r), actual = sqlite.FindConflict(r);
+        std::set<size_t> expected_set(expected.begin(), expected.end());
+        std::set<size_t> actual_set(actual.begin(), actual.end());
+        ASSERT_EQ(actual_set, expected_set) << "row " << r.GetRowIndex();
+        conflicts += expected_set.size();
+    }
+    EXPECT_GT(conflicts, 0u);
+    EXPECT_EQ(ConflictGraph(sqlite), ConflictGraph(memory_));
+}
+
+// rows of every iterator as (rowid, fields), in scan order
+static vector<std::pair<size_t, vector<string>>> ScanRows(const vector<std::unique_ptr<TableIterator>>& iters) {
+    vector<std::pair<size_t, vector<string>>> rows;
+    for (const std::unique_ptr<TableIterator>& iter: iters) {
+        while (iter->HasNext()) {
+            RecordView r = iter->NextView();
+            vector<string> fields;
+            for (size_t col = 0; col < r.GetAttributes().size(); col++) {
+                fields.emplace_back(r.GetField(col));
+            }
+            rows.emplace_back(r.GetRowIndex(), fields);
+        }
+    }
+    return rows;
+}
+
+// deleted rows and a lone large rowid leave some partitions sparse or empty
+TEST_F(FindConflictParityTest, ParallelScanMatchesSerial) {
+    sqlite3* db;
+    sqlite3_open(filename_.c_str(), &db);
+    sqlite3_exec(db, "delete from t where rowid % 3 = 1 or rowid between 200 and 600;"
+            "insert into t(rowid, a, \"b c\", d) values (100000, '7', '1', '0')", NULL, NULL, NULL);
+    sqlite3_close(db);
+
+    SqliteTable serial(filename_, "t", 0);
+    SqliteTable parallel(filename_, "t", 0);
+    parallel.SetScanThreads(4);
+    ASSERT_EQ(parallel.GetPartitionedIterators().size(), 4u);
+    vector<std::pair<size_t, vector<string>>> expected = ScanRows(serial.GetPartitionedIterators());
+    ASSERT_EQ(expected.size(), serial.GetTotalRowNum());
+    EXPECT_EQ(ScanRows(parallel.GetPartitionedIterators()), expected);
+    for (string text: vector<string>{"a = 7", "d != 0", "a = 7 or \"b c\" = 2", "d = 1 and a != 3", ""}) {
+        SubsetQuery query(text);
+        vector<size_t> rows = parallel.Find(query);
+        std::sort(rows.begin(), rows.end());
+        EXPECT_EQ(rows, serial.Find(query)) << text;
+    }
+}
+
+TEST_F(FindConflictParityTest, RowIndexBoundRejectsFarRowids) {
+    SqliteTable table(filename_, "t", 0);
+    EXPECT_EQ(table.GetRowIndexBound(), 1000u);
+    sqlite3* db;
+    sqlite3_open(filename_.c_str(), &db);
+    sqlite3_exec(db, "insert into t(rowid, a) values (1099511627776, '1')", NULL, NULL, NULL);
+    EXPECT_THROW(table.GetRowIndexBound(), const char*);
+    sqlite3_exec(db, "delete from t where rowid = 1099511627776; insert into t(rowid, a) values (-5, '1')",
+            NULL, NULL, NULL);
+    EXPECT_THROW(table.GetRowIndexBound(), const char*);
+    sqlite3_exec(db, "delete from t where rowid = -5", NULL, NULL, NULL);
+    sqlite3_close(db);
+    EXPECT_EQ(table.GetRowIndexBound(), 1000u);
+}
+
+// the connection opened before a constructor throws is closed, LeakSanitizer checks it
+TEST_F(FindConflictParityTest, ConstructorErrorsCloseTheDatabase) {
+    EXPECT_THROW(SqliteTable(filename_, "missing", 0), const char*);
+    SqliteIoProfile in_memory;
+    in_memory.backup_to_memory_ = true;
+    EXPECT_THROW(SqliteTable(filename_, "missing", 0, in_memory), const char*);
+    EXPECT_THROW(SqliteTable(filename_ + ".csv", "missing", 1), const char*);
+}
+
+}  // dcr
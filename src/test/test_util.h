@@ -0,0 +1,145 @@
+#ifndef DCR_TEST_TEST_UTIL_H_
+#define DCR_TEST_TEST_UTIL_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "core/table.h"
+
+namespace dcr {
+
+typedef std::vector<std::vector<size_t>> AdjacencyList;
+
+// G(n, p) with sorted adjacency lists, connected adds a random spanning tree
+inline AdjacencyList RandomGraph(size_t n, double p, std::mt19937* gen, bool connected = false) {
+    std::set<std::pair<size_t, size_t>> edges;
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    for (size_t u = 0; u < n; u++) {
+        for (size_t v = u + 1; v < n; v++) {
+            if (coin(*gen) < p) {
+                edges.insert({u, v});
+            }
+        }
+    }
+    if (connected) {
+        for (size_t v = 1; v < n; v++) {
+            edges.insert({(*gen)() % v, v});
+        }
+    }
+    AdjacencyList adj(n);
+    for (const auto& e: edges) {
+        adj[e.first].push_back(e.second);
+        adj[e.second].push_back(e.first);
+    }
+    for (auto& list: adj) {
+        std::sort(list.begin(), list.end());
+    }
+    return adj;
+}
+
+// weights 1..max_weight
+inline std::vector<double> RandomWeights(size_t n, int max_weight, std::mt19937* gen) {
+    std::vector<double> weights(n);
+    for (double& w: weights) {
+        w = 1 + (*gen)() % max_weight;
+    }
+    return weights;
+}
+
+inline double CoverWeight(const std::vector<size_t>& cover, const std::vector<double>* weights) {
+    double total = 0.0;
+    for (size_t v: cover) {
+        total += weights == nullptr ? 1.0 : (*weights)[v];
+    }
+    return total;
+}
+
+inline bool IsCover(const AdjacencyList& adj, const std::vector<size_t>& cover) {
+    std::vector<char> in(adj.size(), 0);
+    for (size_t v: cover) {
+        in[v] = 1;
+    }
+    for (size_t u = 0; u < adj.size(); u++) {
+        for (size_t v: adj[u]) {
+            if (!in[u] && !in[v]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// minimum (weight) cover by enumerating all subsets, graphs of at most ~16 nodes
+inline std::vector<size_t> BruteForceCover(const AdjacencyList& adj, const std::vector<double>* weights) {
+    size_t n = adj.size();
+    std::vector<size_t> best;
+    double best_weight = -1.0;
+    for (uint32_t mask = 0; mask < (1u << n); mask++) {
+        std::vector<size_t> cover;
+        for (size_t u = 0; u < n; u++) {
+            if (mask >> u & 1) {
+                cover.push_back(u);
+            }
+        }
+        double weight = CoverWeight(cover, weights);
+        if ((best_weight < 0 || weight < best_weight) && IsCover(adj, cover)) {
+            best = cover;
+            best_weight = weight;
+        }
+    }
+    return best;
+}
+
+// connected components of at least two nodes, as adjacency lists over local ids
+inline std::vector<AdjacencyList> Components(const AdjacencyList& adj) {
+    std::vector<AdjacencyList> components;
+    std::vector<size_t> local(adj.size(), adj.size());
+    for (size_t start = 0; start < adj.size(); start++) {
+        if (local[start] != adj.size() || adj[start].empty()) {
+            continue;
+        }
+        std::vector<size_t> members = {start};
+        local[start] = 0;
+        for (size_t i = 0; i < members.size(); i++) {
+            for (size_t v: adj[members[i]]) {
+                if (local[v] == adj.size()) {
+                    local[v] = members.size();
+                    members.push_back(v);
+                }
+            }
+        }
+        AdjacencyList component(members.size());
+        for (size_t i = 0; i < members.size(); i++) {
+            for (size_t v: adj[members[i]]) {
+                component[i].push_back(local[v]);
+            }
+        }
+        components.push_back(component);
+    }
+    return components;
+}
+
+// conflict graph of a table over row indexes, via FindConflict
+inline AdjacencyList ConflictGraph(Table& table) {
+    AdjacencyList adj(table.GetRowIndexBound());
+    auto it = table.GetIterator();
+    while (it->HasNext()) {
+        RecordView r = it->NextView();
+        for (size_t v: table.FindConflict(r)) {
+            if (v != r.GetRowIndex()) {
+                adj[r.GetRowIndex()].push_back(v);
+            }
+        }
+    }
+    for (auto& list: adj) {
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+    }
+    return adj;
+}
+
+}  // dcr
+#endif  // DCR_TEST_TEST_UTIL_H_
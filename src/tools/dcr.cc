@@ -0,0 +1,248 @@
+#include <sys/resource.h>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/graph.h"
+#include "core/phase_timer.h"
+#include "core/subset_query.h"
+#include "core/table.h"
+#include "io/sqlite_table.h"
+#ifdef DCR_WITH_ARROW
+#include "io/arrow_table.h"
+#endif
+
+using dcr::FunctionalDependency;
+using dcr::Graph;
+using dcr::GraphOptions;
+using dcr::PhaseTimes;
+using dcr::ScopedPhase;
+using dcr::SqliteIoProfile;
+using dcr::SqliteTable;
+using dcr::SubsetQuery;
+
+static void Usage() {
+    std::cerr <<
+        "usage: dcr --source FILE --table NAME --fds FILE [options]\n"
+        "  --source FILE           .csv file (through the csv extension), sqlite database or, when\n"
+        "                          built with DCR_WITH_ARROW, .arrow / .feather / .parquet file\n"
+        "  --table NAME            table name\n"
+        "  --fds FILE              one FD per line, e.g. \"zip -> city, state\"; '#' starts a comment\n"
+        "  --algo bllp|telp|pd|lca algorithm (default lca), pd is the primal-dual 2-approximation\n"
+        "  --cost ATTR             numeric per-row repair cost column, the covers minimize their\n"
+        "                          weight and lca estimates the weight fraction\n"
+        "  --epsilon E             sampling error for lca (default 0.1)\n"
+        "  --delta D               lca stops early once the (epsilon, delta) interval is met\n"
+        "  --query Q               subset query for lca (default whole table)\n"
+        "  --implicit              lca on an implicit graph, neighbours generated on demand\n"
+        "  --threads N             parallel table scans over N read-only connections (database files),\n"
+        "                          unweighted pd matches in parallel on N threads\n"
+        "  --io-profile P          default|readonly|memory: sqlite pragmas for read-only analysis,\n"
+        "                          memory also copies a database file into memory first\n";
+}
+
+static std::vector<FunctionalDependency> LoadFds(const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in) {
+        throw "Can't open FD file!";
+    }
+    std::vector<FunctionalDependency> fds;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        fds.push_back(FunctionalDependency::FromString(line));
+    }
+    return fds;
+}
+
+static bool EndsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static double PeakRssMb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;  // ru_maxrss is in KiB on Linux
+}
+
+static void Progress(const std::string& phase, const PhaseTimes& times) {
+    for (const auto& kv: times.Get()) {
+        if (kv.first == phase) {
+            std::cerr << "[" << phase << "] done in " << std::fixed << std::setprecision(1)
+                      << kv.second * 1000.0 << " ms" << std::endl;
+        }
+    }
+}
+
+static std::string CoverResult(Graph* graph, const std::vector<size_t>& vc) {
+    std::string result = "vertex cover size " + std::to_string(vc.size());
+    if (graph->IsWeighted()) {
+        result += ", weight " + std::to_string(graph->GetCoverWeight(vc));
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    std::string source, tablename, fd_file, algo = "lca", query_str, cost_attr;
+    double epsilon = 0.1, delta = 0.0;
+    int threads = 1;
+    std::string io_profile = "default";
+    GraphOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--implicit") {
+            options.implicit_ = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            Usage();
+            return 1;
+        }
+        std::string val = argv[++i];
+        if (arg == "--source") {
+            source = val;
+        } else if (arg == "--table") {
+            tablename = val;
+        } else if (arg == "--fds") {
+            fd_file = val;
+        } else if (arg == "--algo") {
+            algo = val;
+        } else if (arg == "--epsilon") {
+            epsilon = std::atof(val.c_str());
+        } else if (arg == "--delta") {
+            delta = std::atof(val.c_str());
+        } else if (arg == "--query") {
+            query_str = val;
+        } else if (arg == "--cost") {
+            cost_attr = val;
+        } else if (arg == "--threads") {
+            threads = std::atoi(val.c_str());
+        } else if (arg == "--io-profile") {
+            io_profile = val;
+        } else {
+            Usage();
+            return 1;
+        }
+    }
+    if (source.empty() || tablename.empty() || fd_file.empty() ||
+            (algo != "bllp" && algo != "telp" && algo != "pd" && algo != "lca") ||
+            (options.implicit_ && algo != "lca") ||
+            (io_profile != "default" && io_profile != "readonly" && io_profile != "memory")) {
+        Usage();
+        return 1;
+    }
+
+    try {
+        PhaseTimes times;
+        std::unique_ptr<dcr::Table> table;
+        // columns read besides the FDs': the query's for lca, the only algorithm filtering
+        // rows, and the cost column
+        std::vector<std::string> query_attrs = algo == "lca" ? SubsetQuery(query_str).GetAttributes() :
+                                               std::vector<std::string>();
+        if (!cost_attr.empty()) {
+            query_attrs.push_back(cost_attr);
+            options.weight_attr_ = cost_attr;
+        }
+        {
+            ScopedPhase phase(&times, "load");
+            std::vector<FunctionalDependency> fds = LoadFds(fd_file);
+            if (EndsWith(source, ".arrow") || EndsWith(source, ".feather") || EndsWith(source, ".parquet")) {
+#ifdef DCR_WITH_ARROW
+                // read only the columns the FDs and the query refer to
+                std::vector<std::string> projection;
+                for (const FunctionalDependency& fd: fds) {
+                    for (const std::string& attr: fd.GetLeftHandAttrs()) {
+                        projection.push_back(attr);
+                    }
+                    for (const std::string& attr: fd.GetRightHandAttrs()) {
+                        projection.push_back(attr);
+                    }
+                }
+                projection.insert(projection.end(), query_attrs.begin(), query_attrs.end());
+                table.reset(new dcr::ArrowTable(source, tablename, projection));
+#else
+                throw "Arrow / Parquet input needs a build with DCR_WITH_ARROW!";
+#endif
+            } else {
+                SqliteIoProfile profile;
+                if (io_profile != "default") {
+                    profile = SqliteIoProfile::ReadOnlyAnalysis();
+                    profile.backup_to_memory_ = io_profile == "memory";
+                }
+                table.reset(new SqliteTable(source, tablename, EndsWith(source, ".csv") ? 1 : 0, profile));
+            }
+            table->LoadFunctionalDependencies(fds);
+            table->ProjectOnDependencies(query_attrs);
+            table->SetScanThreads(threads > 0 ? threads : 1);
+        }
+        Progress("load", times);
+
+        Graph graph(table.get(), options);
+        Progress("graph build", graph.GetPhaseTimes());
+
+        std::string result;
+        if (algo == "bllp" || algo == "telp") {
+            std::vector<size_t> vc = algo == "bllp" ? graph.VertexCoverBllp() : graph.VertexCoverTelp();
+            result = CoverResult(&graph, vc);
+        } else if (algo == "pd") {
+            // the parallel rounds only build an unweighted matching
+            std::vector<size_t> vc = threads > 1 && !graph.IsWeighted() ? graph.VertexCoverPrimalDualParallel(threads) :
+                                     graph.VertexCoverPrimalDual();
+            result = CoverResult(&graph, vc);
+        } else {
+            SubsetQuery query(query_str);
+            if (delta > 0.0) {
+                dcr::InconsistencyEstimate estimate = graph.InconsistencyDegreeAdaptive(epsilon, delta, query);
+                result = "inconsistency degree " + std::to_string(estimate.estimate_) + " [" +
+                         std::to_string(estimate.lower_) + ", " + std::to_string(estimate.upper_) + "] after " +
+                         std::to_string(estimate.samples_) + " samples";
+            } else {
+                result = "inconsistency degree " + std::to_string(graph.InconsistencyDegree(epsilon, query));
+            }
+        }
+
+        std::cout << "phase times (ms):" << std::endl;
+        std::cout << std::fixed << std::setprecision(1);
+        const PhaseTimes* all_phases[] = {&times, &graph.GetPhaseTimes()};
+        for (const PhaseTimes* phases: all_phases) {
+            for (const auto& kv: phases->Get()) {
+                std::cout << "  " << std::left << std::setw(12) << kv.first << std::right << std::setw(12)
+                          << kv.second * 1000.0 << std::endl;
+            }
+        }
+        std::cout << "peak rss: " << PeakRssMb() << " MiB" << std::endl;
+        std::cout << "graph: " << graph.GetNodeNum() << " nodes, " << graph.GetEdgeNum() << " edges" << std::endl;
+        std::cout << "result: " << result << std::endl;
+#ifndef DCR_DISABLE_STATS
+        if (algo == "lca") {
+            const dcr::LcaStats& stats = graph.GetLcaStats();
+            std::cout << "lca: " << stats.in_matching_calls_ << " InMatching calls, memo " << stats.memo_hits_
+                      << " hits / " << stats.memo_misses_ << " misses, max depth " << stats.max_depth_ << ", "
+                      << stats.edges_scanned_ << " edges scanned, " << stats.oracle_checks_ << " oracle checks"
+                      << std::endl;
+            std::cout << "probe cost histogram (InMatching calls per sample):" << std::endl;
+            for (size_t b = 0; b < stats.probe_histogram_.size(); b++) {
+                size_t low = b == 0 ? 0 : (size_t)1 << (b - 1);
+                size_t high = b == 0 ? 0 : ((size_t)1 << b) - 1;
+                std::cout << "  [" << low << ", " << high << "]: " << stats.probe_histogram_[b] << std::endl;
+            }
+        }
+#endif
+    } catch (const char* msg) {
+        std::cerr << msg << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        // e.g. InvalidExpressionException of a malformed --query
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/table.h"
+#include "gen/dirty_data_generator.h"
+#include "gen/row_sink.h"
+
+using dcr::CsvSink;
+using dcr::DirtyDataGenerator;
+using dcr::FunctionalDependency;
+using dcr::GeneratorSpec;
+using dcr::GroupDistribution;
+using dcr::RowSink;
+using dcr::SqliteSink;
+
+static void Usage() {
+    std::cerr <<
+        "usage: dcr_gen --rows N --fd \"A,B->C\" [--fd ...] --out FILE\n"
+        "  --violation RATE        fraction of rows violating each FD (default 0)\n"
+        "  --groups G              distinct LHS values per FD (default 1000)\n"
+        "  --zipf S                Zipfian LHS group sizes with exponent S (default uniform)\n"
+        "  --card ATTR=N           domain size of an attribute\n"
+        "  --default-card N        domain size of the other attributes (default 1000)\n"
+        "  --extra ATTR            attribute outside every FD\n"
+        "  --seed S                random seed (default 42)\n"
+        "  --format csv|sqlite     output format (default csv)\n"
+        "  --table NAME            table name for sqlite output (default t)\n";
+}
+
+int main(int argc, char** argv) {
+    GeneratorSpec spec;
+    std::string out, format = "csv", tablename = "t";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            Usage();
+            return 1;
+        }
+        std::string val = argv[++i];
+        if (arg == "--rows") {
+            spec.rows_ = std::strtoull(val.c_str(), NULL, 10);
+        } else if (arg == "--fd") {
+            spec.fds_.push_back(FunctionalDependency::FromString(val));
+        } else if (arg == "--violation") {
+            spec.violation_rate_ = std::atof(val.c_str());
+        } else if (arg == "--groups") {
+            spec.lhs_groups_ = std::strtoull(val.c_str(), NULL, 10);
+        } else if (arg == "--zipf") {
+            spec.group_distribution_ = GroupDistribution::kZipfian;
+            spec.zipf_exponent_ = std::atof(val.c_str());
+        } else if (arg == "--card") {
+            size_t eq = val.find('=');
+            if (eq == std::string::npos) {
+                Usage();
+                return 1;
+            }
+            spec.cardinalities_[val.substr(0, eq)] = std::strtoull(val.c_str() + eq + 1, NULL, 10);
+        } else if (arg == "--default-card") {
+            spec.default_cardinality_ = std::strtoull(val.c_str(), NULL, 10);
+        } else if (arg == "--extra") {
+            spec.extra_attrs_.push_back(val);
+        } else if (arg == "--seed") {
+            spec.seed_ = std::strtoull(val.c_str(), NULL, 10);
+        } else if (arg == "--format") {
+            format = val;
+        } else if (arg == "--table") {
+            tablename = val;
+        } else if (arg == "--out") {
+            out = val;
+        } else {
+            Usage();
+            return 1;
+        }
+    }
+    if (out.empty() || spec.fds_.empty() || (format != "csv" && format != "sqlite")) {
+        Usage();
+        return 1;
+    }
+
+    try {
+        DirtyDataGenerator generator(spec);
+        std::unique_ptr<RowSink> sink;
+        if (format == "csv") {
+            sink.reset(new CsvSink(out, generator.GetAttributes()));
+        } else {
+            sink.reset(new SqliteSink(out, tablename, generator.GetAttributes()));
+        }
+
+        std::vector<std::string> values;
+        while (generator.HasNext()) {
+            generator.Next(&values);
+            sink->Write(values);
+        }
+        sink->Close();
+
+        size_t cover;
+        if (generator.MinimumVertexCoverSize(&cover)) {
+            std::cout << "Minimum vertex cover size: " << cover << std::endl;
+        } else {
+            std::cout << "Minimum vertex cover not computable for multiple FDs" << std::endl;
+        }
+    } catch (const char* msg) {
+        std::cerr << msg << std::endl;
+        return 1;
+    }
+    return 0;
+}